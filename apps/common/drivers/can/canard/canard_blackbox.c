@@ -0,0 +1,190 @@
+/**
+ * @file canard_blackbox.c
+ * @brief Event recorder that survives resets
+ *
+ * A writer claims a slot with one atomic increment of the sequence number
+ * and fills it without further locking, so recording is safe from ISRs
+ * and costs a few dozen cycles. A reader racing a writer on the same slot
+ * may see a half written event; with a ring of hundreds of events that
+ * only affects the newest one.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#if defined(CONFIG_HWINFO)
+#include <zephyr/drivers/hwinfo.h>
+#endif
+#include <string.h>
+#include <lib/bldcmotor/motor.h>
+#include "canard_blackbox.h"
+#include "../stm32_can.h"
+
+LOG_MODULE_REGISTER(canard_blackbox, LOG_LEVEL_INF);
+
+#define BLACKBOX_MAGIC   0x424C4B31U  /* "BLK1" */
+#define BLACKBOX_EVENTS  CONFIG_CANARD_BLACKBOX_EVENTS
+#define BLACKBOX_MASK    (BLACKBOX_EVENTS - 1U)
+#define BLACKBOX_RESP_HEADER 6U
+
+BUILD_ASSERT((BLACKBOX_EVENTS & BLACKBOX_MASK) == 0U,
+             "CONFIG_CANARD_BLACKBOX_EVENTS must be a power of two");
+
+struct blackbox_event {
+    uint32_t cycles;
+    uint8_t type;
+    uint8_t a;
+    uint16_t b;
+};
+BUILD_ASSERT(sizeof(struct blackbox_event) == CANARD_BLACKBOX_EVENT_SIZE);
+
+/* 复位后不清零, 由 magic 与容量判断内容是否有效 */
+static struct {
+    uint32_t magic;
+    uint32_t capacity;
+    uint32_t boots;
+    uint32_t tail;      ///< CLEAR 之后最旧的有效序号
+    atomic_t head;      ///< 下一个事件的序号
+    struct blackbox_event ring[BLACKBOX_EVENTS];
+} blackbox __noinit;
+
+/* 电机线程跟踪的上一次取值, 0xFF 表示尚未采样 */
+static uint8_t last_app_state = 0xFF;
+static uint8_t last_motor_fsm = 0xFF;
+static uint8_t last_mode = 0xFF;
+static uint8_t last_state = 0xFF;
+
+/* canard 线程已记录到的溢出计数 */
+static uint32_t last_overrun[CAN_IFACE_COUNT];
+
+void canard_blackbox_record(uint8_t type, uint8_t a, uint16_t b)
+{
+    const uint32_t seq = (uint32_t)atomic_inc(&blackbox.head);
+    struct blackbox_event *ev = &blackbox.ring[seq & BLACKBOX_MASK];
+
+    ev->cycles = k_cycle_get_32();
+    ev->type = type;
+    ev->a = a;
+    ev->b = b;
+}
+
+static uint32_t blackbox_oldest(uint32_t head)
+{
+    const uint32_t floor = (head > BLACKBOX_EVENTS) ? head - BLACKBOX_EVENTS : 0U;
+
+    return MAX(floor, blackbox.tail);
+}
+
+void canard_blackbox_init(void)
+{
+    uint32_t cause = 0;
+    uint32_t kept;
+
+    if (blackbox.magic != BLACKBOX_MAGIC || blackbox.capacity != BLACKBOX_EVENTS ||
+        blackbox.tail > (uint32_t)atomic_get(&blackbox.head)) {
+        memset(&blackbox, 0, sizeof(blackbox));
+        blackbox.magic = BLACKBOX_MAGIC;
+        blackbox.capacity = BLACKBOX_EVENTS;
+    }
+    kept = (uint32_t)atomic_get(&blackbox.head);
+    kept -= blackbox_oldest(kept);
+    blackbox.boots++;
+#if defined(CONFIG_HWINFO)
+    if (hwinfo_get_reset_cause(&cause) == 0) {
+        hwinfo_clear_reset_cause();
+    }
+#endif
+    canard_blackbox_record(CANARD_BLACKBOX_BOOT, (uint8_t)blackbox.boots, (uint16_t)cause);
+    LOG_INF("Boot %u, %u events kept, reset cause 0x%x", blackbox.boots, kept, cause);
+}
+
+static void track(uint8_t type, uint8_t *last, uint8_t now)
+{
+    if (now != *last) {
+        canard_blackbox_record(type, now, *last);
+        *last = now;
+    }
+}
+
+void canard_blackbox_track(const struct device *motor, uint8_t app_state)
+{
+    const struct motor_config *cfg = motor->config;
+
+    track(CANARD_BLACKBOX_APP_FSM, &last_app_state, app_state);
+    track(CANARD_BLACKBOX_MOTOR_FSM, &last_motor_fsm, (uint8_t)cfg->fsm->chState);
+    track(CANARD_BLACKBOX_MOTOR_MODE, &last_mode, (uint8_t)motor_get_mode(motor));
+    track(CANARD_BLACKBOX_MOTOR_STATE, &last_state, (uint8_t)motor_get_state(motor));
+}
+
+void canard_blackbox_poll(void)
+{
+    // 溢出在中断中只计数, 这里合并成一条事件, 避免溢出风暴冲掉环形缓冲
+    for (uint8_t i = 0; i < CAN_IFACE_COUNT; i++) {
+        const uint32_t n = can_iface_stats[i].rx_overrun;
+
+        if (n != last_overrun[i]) {
+            canard_blackbox_record(CANARD_BLACKBOX_RX_OVERRUN, i,
+                                   (uint16_t)MIN(n - last_overrun[i], UINT16_MAX));
+            last_overrun[i] = n;
+        }
+    }
+}
+
+static size_t blackbox_status(uint8_t *resp)
+{
+    resp[0] = 0;
+    sys_put_le32((uint32_t)atomic_get(&blackbox.head), &resp[1]);
+    sys_put_le16(BLACKBOX_EVENTS, &resp[5]);
+    resp[7] = (uint8_t)blackbox.boots;
+    sys_put_le32(sys_clock_hw_cycles_per_sec(), &resp[8]);
+    return 12U;
+}
+
+static size_t blackbox_read(const uint8_t *req, size_t len, uint8_t *resp, size_t size)
+{
+    if (len < 5U) {
+        resp[0] = EINVAL;
+        return 1U;
+    }
+    const uint32_t head = (uint32_t)atomic_get(&blackbox.head);
+    const uint32_t first = MAX(sys_get_le32(&req[1]), blackbox_oldest(head));
+    const size_t fit = (size - BLACKBOX_RESP_HEADER) / CANARD_BLACKBOX_EVENT_SIZE;
+    const uint8_t n = (first < head) ? (uint8_t)MIN(fit, (size_t)(head - first)) : 0U;
+    uint8_t *p = &resp[BLACKBOX_RESP_HEADER];
+
+    for (uint8_t i = 0; i < n; i++) {
+        const struct blackbox_event *ev = &blackbox.ring[(first + i) & BLACKBOX_MASK];
+
+        sys_put_le32(ev->cycles, &p[0]);
+        p[4] = ev->type;
+        p[5] = ev->a;
+        sys_put_le16(ev->b, &p[6]);
+        p += CANARD_BLACKBOX_EVENT_SIZE;
+    }
+    resp[0] = 0;
+    sys_put_le32(first, &resp[1]);
+    resp[5] = n;
+    return BLACKBOX_RESP_HEADER + (size_t)n * CANARD_BLACKBOX_EVENT_SIZE;
+}
+
+size_t canard_blackbox_handle(const uint8_t *req, size_t len, uint8_t *resp, size_t size)
+{
+    if (len < 1U || size < CANARD_BLACKBOX_RESPONSE_MAX) {
+        return 0;
+    }
+    switch (req[0]) {
+    case CANARD_BLACKBOX_OP_STATUS:
+        return blackbox_status(resp);
+    case CANARD_BLACKBOX_OP_READ:
+        return blackbox_read(req, len, resp, CANARD_BLACKBOX_RESPONSE_MAX);
+    case CANARD_BLACKBOX_OP_CLEAR:
+        blackbox.tail = (uint32_t)atomic_get(&blackbox.head);
+        resp[0] = 0;
+        return 1U;
+    default:
+        resp[0] = ENOTSUP;
+        return 1U;
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ * @file canard_blackbox.h
+ * @brief Event recorder that survives resets
+ *
+ * Fixed size binary events are appended to a ring in no-init RAM from any
+ * context (threads and ISRs). After a watchdog or software reset the ring
+ * is kept and a BOOT event separates the runs; after a power cycle it
+ * starts empty. Timestamps are raw cycle counter values, which restart at
+ * every boot and wrap, so only the order and short intervals are
+ * meaningful.
+ *
+ * Events are numbered by a free-running sequence number; the ring holds
+ * the last CONFIG_CANARD_BLACKBOX_EVENTS of them. Retrieval is a raw
+ * service on CONFIG_CANARD_BLACKBOX_SERVICE_ID (multi-byte fields little
+ * endian):
+ *   STATUS  -> [0] err [1..4] next sequence [5..6] capacity [7] boots
+ *              [8..11] cycle counter frequency Hz
+ *   READ    [1..4] first sequence, clamped to the oldest kept event
+ *           -> [0] err [1..4] first sequence [5] n, n events of 8 bytes:
+ *              [0..3] cycles [4] type [5] a [6..7] b
+ *   CLEAR   -> [0] err
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CANARD_BLACKBOX_H_
+#define CANARD_BLACKBOX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+
+#define CANARD_BLACKBOX_EVENT_SIZE 8U
+#define CANARD_BLACKBOX_REQUEST_EXTENT 5U
+#define CANARD_BLACKBOX_RESPONSE_MAX \
+    (6U + CANARD_BLACKBOX_EVENT_SIZE * CONFIG_CANARD_BLACKBOX_CHUNK_EVENTS)
+
+enum canard_blackbox_op {
+    CANARD_BLACKBOX_OP_STATUS = 0,
+    CANARD_BLACKBOX_OP_READ = 1,
+    CANARD_BLACKBOX_OP_CLEAR = 2,
+};
+
+/* 事件类型及 a/b 字段含义 */
+enum canard_blackbox_type {
+    CANARD_BLACKBOX_BOOT = 1,         ///< a: boot count, b: reset cause (hwinfo)
+    CANARD_BLACKBOX_RX_REQUEST = 2,   ///< a: source node, b: service ID
+    CANARD_BLACKBOX_APP_FSM = 3,      ///< a: new chState, b: previous chState
+    CANARD_BLACKBOX_MOTOR_FSM = 4,    ///< a: new chState, b: previous chState
+    CANARD_BLACKBOX_MOTOR_MODE = 5,   ///< a: new mode, b: previous mode
+    CANARD_BLACKBOX_MOTOR_STATE = 6,  ///< a: new state, b: previous state
+    CANARD_BLACKBOX_TX_DROP = 7,      ///< a: iface, b: frames dropped (failed or expired)
+    CANARD_BLACKBOX_RX_OVERRUN = 8,   ///< a: iface, b: frames lost since the last event
+    CANARD_BLACKBOX_CAN_STATE = 9,    ///< a: iface, b: enum can_state
+    CANARD_BLACKBOX_BOOT_TIMING = 10, ///< a: milestone (0 CAN up, 1 heartbeat, 2 command), b: ms
+};
+
+/** @brief Validate or reset the ring and log a BOOT event, from main() before any thread starts */
+void canard_blackbox_init(void);
+
+/** @brief Append one event (any context) */
+void canard_blackbox_record(uint8_t type, uint8_t a, uint16_t b);
+
+/**
+ * @brief Record FSM, mode and state changes (motor thread, every control loop)
+ * @param app_state chState of the application FSM
+ */
+void canard_blackbox_track(const struct device *motor, uint8_t app_state);
+
+/** @brief Turn RX overrun counters into events (canard thread) */
+void canard_blackbox_poll(void);
+
+/**
+ * @brief Handle one retrieval request (canard thread)
+ * @return Response length written to @p resp
+ */
+size_t canard_blackbox_handle(const uint8_t *req, size_t len, uint8_t *resp, size_t size);
+
+#endif /* CANARD_BLACKBOX_H_ */
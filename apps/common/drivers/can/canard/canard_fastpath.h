@@ -0,0 +1,76 @@
+/**
+ * @file canard_fastpath.h
+ * @brief Fixed-layout decoders for the hottest service requests
+ *
+ * SetTargetValue arrives at the host command rate and only carries a
+ * short float array, yet the generated _deserialize_ walks it bit by bit
+ * through the generic Nunavut helpers and a nested call per element.
+ * The decoder here reads the byte-aligned layout directly and produces
+ * the same result as the generated code for every input: same return
+ * code, same consumed size, same elements, including Cyphal implicit
+ * zero extension of truncated payloads. The layout is checked against
+ * the generated header at build time; apps/dsdl_bench compares the two
+ * decoders over edge cases and measures both.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CANARD_FASTPATH_H_
+#define CANARD_FASTPATH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <dinosaurs/actuator/wheel_motor/SetTargetValue_2_0.h>
+
+#define SET_TARGET_VELOCITY_CAPACITY \
+    dinosaurs_actuator_wheel_motor_SetTargetValue_Request_2_0_velocity_ARRAY_CAPACITY_
+
+/* uint8 长度前缀 + float32[<=2], 均按字节对齐 */
+BUILD_ASSERT(dinosaurs_actuator_wheel_motor_SetTargetValue_Request_2_0_velocity_ARRAY_IS_VARIABLE_LENGTH_ &&
+             SET_TARGET_VELOCITY_CAPACITY <= UINT8_MAX &&
+             dinosaurs_actuator_wheel_motor_SetTargetValue_Request_2_0_SERIALIZATION_BUFFER_SIZE_BYTES_ ==
+             1U + 4U * SET_TARGET_VELOCITY_CAPACITY,
+             "SetTargetValue.Request layout changed, update canard_fastpath.h");
+
+/**
+ * @brief Drop-in replacement for the generated SetTargetValue request deserializer
+ * @param out Decoded request, elements past count are left untouched
+ * @param buf Payload, may be NULL when @p inout_size is 0
+ * @param inout_size Payload size in, consumed bytes out
+ * @return NUNAVUT_SUCCESS or a negative Nunavut error code
+ */
+static inline int8_t canard_fast_set_target_decode(dinosaurs_actuator_wheel_motor_SetTargetValue_Request_2_0 *out,
+                                                   const uint8_t *buf, size_t *inout_size)
+{
+    const size_t len = *inout_size;
+    const size_t count = (len > 0U) ? buf[0] : 0U;
+
+    if (count > SET_TARGET_VELOCITY_CAPACITY) {
+        return -NUNAVUT_ERROR_REPRESENTATION_BAD_ARRAY_LENGTH;
+    }
+    out->velocity.count = count;
+    for (size_t i = 0; i < count; i++) {
+        const size_t at = 1U + 4U * i;
+        uint32_t bits;
+
+        if (len >= at + 4U) {
+            bits = sys_get_le32(&buf[at]);
+        } else {
+            // 截断的负载按零扩展, 与生成代码一致
+            uint8_t tail[4] = {0};
+
+            if (len > at) {
+                memcpy(tail, &buf[at], len - at);
+            }
+            bits = sys_get_le32(tail);
+        }
+        memcpy(&out->velocity.elements[i].meter_per_second, &bits, sizeof(bits));
+    }
+    *inout_size = MIN(1U + 4U * count, len);
+    return NUNAVUT_SUCCESS;
+}
+
+#endif /* CANARD_FASTPATH_H_ */
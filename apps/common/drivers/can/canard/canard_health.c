@@ -0,0 +1,192 @@
+/**
+ * @file canard_health.c
+ * @brief libcanard heap and queue health accounting
+ *
+ * The heap peak comes from the sys_heap runtime statistics; its maximum
+ * is reset at every heartbeat so the advisory level follows the current
+ * load, the peak since boot is kept here for the diagnostics message.
+ * RX queue overruns are counted by the CAN driver and only read here.
+ * Transfer-ID gaps are tracked per (subscription, sender) in a small
+ * table; when it is full the oldest entry is replaced, and a sender seen
+ * for the first time only sets the reference.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#include "canard.h"
+#include "canard_health.h"
+#include "../stm32_can.h"
+#include "log_rl.h"
+
+LOG_MODULE_REGISTER(canard_health, LOG_LEVEL_INF);
+
+static struct {
+    struct sys_heap *heap;
+    uint16_t tx_capacity;
+    uint32_t heap_oom;
+    uint32_t tx_fail;
+    uint32_t rx_drop;           //丢失的传输, 不含 RX 队列溢出
+    uint16_t tx_hwm;            //开机以来
+    uint16_t tx_hwm_interval;   //本心跳周期
+    uint16_t heap_peak_permille;
+    uint8_t flags;              //上一个心跳周期的标志
+} health;
+
+/* 上一个心跳时的计数, 用于判断本周期是否有新事件 */
+static struct {
+    uint32_t heap_oom;
+    uint32_t tx_fail;
+    uint32_t rx_drop;
+} reported;
+
+/* 每个发送方会话最后收到的 transfer-ID */
+static struct rx_sender {
+    const CanardRxSubscription *sub;
+    uint8_t node_id;
+    uint8_t transfer_id;
+} rx_senders[CONFIG_CANARD_HEALTH_RX_SENDERS];
+static uint8_t rx_sender_next;  //表满时下一个替换的位置
+
+static uint32_t rx_overruns(void)
+{
+    uint32_t sum = 0;
+
+    for (uint8_t i = 0; i < CAN_IFACE_COUNT; i++) {
+        sum += can_iface_stats[i].rx_overrun;
+    }
+    return sum;
+}
+
+void canard_health_init(struct sys_heap *heap, size_t tx_capacity)
+{
+    health.heap = heap;
+    health.tx_capacity = (uint16_t)MIN(tx_capacity, UINT16_MAX);
+}
+
+void canard_health_heap_oom(void)
+{
+    health.heap_oom++;
+}
+
+void canard_health_tx_push(int32_t result, size_t queue_size)
+{
+    if (result < 0) {
+        health.tx_fail++;
+        LOG_RL_WRN("TX push failed: %d, queue %u", result, (unsigned)queue_size);
+    }
+    health.tx_hwm = MAX(health.tx_hwm, (uint16_t)queue_size);
+    health.tx_hwm_interval = MAX(health.tx_hwm_interval, (uint16_t)queue_size);
+}
+
+static void rx_track(const CanardRxSubscription *sub, const CanardRxTransfer *transfer)
+{
+    const uint8_t node_id = transfer->metadata.remote_node_id;
+    const uint8_t tid = transfer->metadata.transfer_id;
+
+    if (node_id > CANARD_NODE_ID_MAX) {
+        return;  //匿名传输没有会话
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(rx_senders); i++) {
+        struct rx_sender *s = &rx_senders[i];
+
+        if (s->sub == sub && s->node_id == node_id) {
+            // 同一 transfer-ID 是传输 ID 超时后的重发, 不算丢失
+            const uint8_t lost = (uint8_t)(tid - s->transfer_id - 1U) & CANARD_TRANSFER_ID_MAX;
+
+            if (tid != s->transfer_id && lost != 0U) {
+                health.rx_drop += lost;
+                LOG_RL_WRN("RX lost %u transfer(s) on port %u from node %u",
+                           lost, sub->port_id, node_id);
+            }
+            s->transfer_id = tid;
+            return;
+        }
+        if (s->sub == NULL) {
+            rx_sender_next = (uint8_t)i;
+            break;
+        }
+    }
+    rx_senders[rx_sender_next] = (struct rx_sender){ .sub = sub, .node_id = node_id, .transfer_id = tid };
+    rx_sender_next = (uint8_t)((rx_sender_next + 1U) % ARRAY_SIZE(rx_senders));
+}
+
+void canard_health_rx_accept(int8_t result, const CanardRxSubscription *sub,
+                             const CanardRxTransfer *transfer)
+{
+    if (result < 0) {
+        health.rx_drop++;
+        LOG_RL_WRN("RX transfer dropped: %d", result);
+    } else if (result > 0 && sub != NULL) {
+        rx_track(sub, transfer);
+    }
+}
+
+/* 本周期堆使用峰值(千分比), 并清零峰值开始下一个周期 */
+static uint16_t heap_interval_permille(void)
+{
+    struct sys_memory_stats st;
+
+    if (health.heap == NULL || sys_heap_runtime_stats_get(health.heap, &st) != 0) {
+        return 0;
+    }
+    const size_t total = st.allocated_bytes + st.free_bytes;
+    const uint16_t permille = (total == 0U) ? 0U :
+                              (uint16_t)((uint64_t)st.max_allocated_bytes * 1000U / total);
+
+    (void)sys_heap_runtime_stats_reset_max(health.heap);
+    health.heap_peak_permille = MAX(health.heap_peak_permille, permille);
+    return permille;
+}
+
+uint8_t canard_health_heartbeat(uint8_t *vendor)
+{
+    static uint32_t rx_overrun_reported;
+    const uint32_t overrun = rx_overruns();
+    uint8_t flags = 0;
+
+    if (health.heap_oom != reported.heap_oom) {
+        flags |= CANARD_HEALTH_FLAG_HEAP_OOM;
+    }
+    if (health.tx_fail != reported.tx_fail) {
+        flags |= CANARD_HEALTH_FLAG_TX_FAIL;
+    }
+    if (health.rx_drop != reported.rx_drop || overrun != rx_overrun_reported) {
+        flags |= CANARD_HEALTH_FLAG_RX_DROP;
+    }
+    if (health.tx_capacity != 0U &&
+        (uint32_t)health.tx_hwm_interval * 100U >=
+        (uint32_t)health.tx_capacity * CONFIG_CANARD_HEALTH_ADVISORY_PCT) {
+        flags |= CANARD_HEALTH_FLAG_TX_QUEUE;
+    }
+    if (heap_interval_permille() >= CONFIG_CANARD_HEALTH_ADVISORY_PCT * 10U) {
+        flags |= CANARD_HEALTH_FLAG_HEAP_HIGH;
+    }
+
+    reported.heap_oom = health.heap_oom;
+    reported.tx_fail = health.tx_fail;
+    reported.rx_drop = health.rx_drop;
+    rx_overrun_reported = overrun;
+    health.tx_hwm_interval = 0;
+
+    if (flags != 0U && health.flags == 0U) {
+        LOG_WRN("Health advisory, flags 0x%02x", flags);
+    }
+    health.flags = flags;
+    *vendor = flags;
+    return (flags != 0U) ? CANARD_HEALTH_ADVISORY : CANARD_HEALTH_NOMINAL;
+}
+
+void canard_health_encode(uint8_t buf[CANARD_HEALTH_STATUS_SIZE])
+{
+    sys_put_le16((uint16_t)health.heap_oom, &buf[0]);
+    sys_put_le16((uint16_t)health.tx_fail, &buf[2]);
+    sys_put_le16((uint16_t)(health.rx_drop + rx_overruns()), &buf[4]);
+    sys_put_le16(health.tx_hwm, &buf[6]);
+    sys_put_le16(health.tx_capacity, &buf[8]);
+    sys_put_le16(health.heap_peak_permille, &buf[10]);
+    buf[12] = health.flags;
+    sys_put_le16((uint16_t)atomic_get(&log_rl_dropped), &buf[13]);
+}
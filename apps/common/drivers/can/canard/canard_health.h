@@ -0,0 +1,129 @@
+/**
+ * @file canard_health.h
+ * @brief libcanard heap and queue health accounting
+ *
+ * Counts what libcanard otherwise drops silently: heap allocation
+ * failures, transfers refused by canardTxPush, received transfers lost
+ * and frames lost in the RX queues, and tracks the TX queue and heap
+ * high-water marks.
+ *
+ * canardRxAccept does not report reassembly failures (CRC, toggle bit,
+ * missing frames), the partial transfer is simply discarded. They are
+ * counted from the transfer-ID sequence instead: each sender increments
+ * the transfer-ID by one per transfer on a session, so a gap between two
+ * accepted transfers is the number lost in between. The last transfer-ID
+ * is kept for up to CONFIG_CANARD_HEALTH_RX_SENDERS sessions; a sender
+ * restarting its counter shows up as a single gap. The heartbeat carries a summary in its
+ * vendor-specific status byte and reports ADVISORY health while any
+ * flag is set; the full counters are published on
+ * CONFIG_CANARD_HEALTH_PORT_ID.
+ *
+ * Flags cover the last heartbeat interval, so a single event is
+ * reported once and the node returns to NOMINAL when it stops.
+ * All functions run in the canard thread.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CANARD_HEALTH_H_
+#define CANARD_HEALTH_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys/sys_heap.h>
+#include <zephyr/sys/util.h>
+#include "canard.h"
+
+/* 诊断消息长度, 经典 CAN 下三帧 */
+#define CANARD_HEALTH_STATUS_SIZE 15U
+
+/* uavcan.node.Health.1.0 */
+#define CANARD_HEALTH_NOMINAL  0U
+#define CANARD_HEALTH_ADVISORY 1U
+
+/* 心跳 vendor-specific 状态字节 */
+#define CANARD_HEALTH_FLAG_HEAP_OOM   BIT(0)   ///< memAllocate failed
+#define CANARD_HEALTH_FLAG_TX_FAIL    BIT(1)   ///< canardTxPush refused a transfer
+#define CANARD_HEALTH_FLAG_RX_DROP    BIT(2)   ///< Received transfer lost or RX queue overrun
+#define CANARD_HEALTH_FLAG_TX_QUEUE   BIT(3)   ///< TX queue above the advisory level
+#define CANARD_HEALTH_FLAG_HEAP_HIGH  BIT(4)   ///< Heap usage above the advisory level
+
+#if defined(CONFIG_CANARD_HEALTH)
+
+/**
+ * @brief Start accounting
+ * @param heap Heap backing libcanard allocations
+ * @param tx_capacity Capacity of each TX queue, frames
+ */
+void canard_health_init(struct sys_heap *heap, size_t tx_capacity);
+
+/** @brief Record a failed libcanard allocation */
+void canard_health_heap_oom(void);
+
+/**
+ * @brief Record the outcome of canardTxPush on one interface
+ * @param result Return value of canardTxPush
+ * @param queue_size Queue depth after the push, frames
+ */
+void canard_health_tx_push(int32_t result, size_t queue_size);
+
+/**
+ * @brief Record the outcome of canardRxAccept
+ * @param result Return value of canardRxAccept
+ * @param sub Subscription of the transfer, used when @p result is 1
+ * @param transfer Accepted transfer, used when @p result is 1
+ */
+void canard_health_rx_accept(int8_t result, const CanardRxSubscription *sub,
+                             const CanardRxTransfer *transfer);
+
+/**
+ * @brief Close the heartbeat interval
+ * @param vendor Set to the vendor-specific status byte
+ * @return Health value for the heartbeat
+ */
+uint8_t canard_health_heartbeat(uint8_t *vendor);
+
+/**
+ * @brief Serialize the diagnostics message
+ *
+ *   [0..1]   heap allocation failures, u16 LE, wrapping
+ *   [2..3]   TX push failures, u16 LE, wrapping
+ *   [4..5]   RX drops (transfer-ID gaps, canardRxAccept errors and queue
+ *            overruns), u16 LE, wrapping
+ *   [6..7]   TX queue high-water mark since boot, frames, u16 LE
+ *   [8..9]   TX queue capacity, frames, u16 LE
+ *   [10..11] heap high-water mark since boot, permille, u16 LE
+ *   [12]     flags of the last heartbeat, as in the vendor status byte
+ *   [13..14] log messages suppressed by LOG_RL_* since boot, u16 LE, wrapping
+ */
+void canard_health_encode(uint8_t buf[CANARD_HEALTH_STATUS_SIZE]);
+
+#else
+
+static inline void canard_health_heap_oom(void)
+{
+}
+
+static inline void canard_health_tx_push(int32_t result, size_t queue_size)
+{
+    ARG_UNUSED(result);
+    ARG_UNUSED(queue_size);
+}
+
+static inline void canard_health_rx_accept(int8_t result, const CanardRxSubscription *sub,
+                                           const CanardRxTransfer *transfer)
+{
+    ARG_UNUSED(result);
+    ARG_UNUSED(sub);
+    ARG_UNUSED(transfer);
+}
+
+static inline uint8_t canard_health_heartbeat(uint8_t *vendor)
+{
+    *vendor = 0U;
+    return CANARD_HEALTH_NOMINAL;
+}
+
+#endif /* CONFIG_CANARD_HEALTH */
+
+#endif /* CANARD_HEALTH_H_ */
@@ -0,0 +1,1747 @@
+
+/*
+
+uavcan协议的接口文件
+
+
+
+*/
+
+
+
+#include "canard.h"
+#include "zephyr/posix/sys/stat.h"
+#include "zephyr/sys/util.h"
+#include <stdint.h>
+#include <math.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/drivers/can.h>
+#include <dinosaurs/PortId_1_0.h>
+/* 只包含启用的服务, 未用到的 DSDL 编解码不进入镜像 */
+#if defined(CONFIG_CANARD_SERVICE_ENABLE)
+#include <dinosaurs/actuator/wheel_motor/Enable_1_0.h>
+#endif
+#if defined(CONFIG_CANARD_SERVICE_SET_TARGET)
+#include <dinosaurs/actuator/wheel_motor/SetTargetValue_2_0.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/spsc_lockfree.h>
+#if defined(CONFIG_CANARD_FAST_DECODE)
+#include "canard_fastpath.h"
+#endif
+#endif
+#if defined(CONFIG_CANARD_SERVICE_PID_PARAMETER)
+#include <dinosaurs/actuator/wheel_motor/PidParameter_1_0.h>
+#endif
+#if defined(CONFIG_CANARD_SERVICE_SET_MODE)
+#include <dinosaurs/actuator/wheel_motor/SetMode_2_0.h>
+#endif
+#if defined(CONFIG_CANARD_SERVICE_OPERATE_REMOTE_DEVICE)
+#include <dinosaurs/peripheral/OperateRemoteDevice_1_0.h>
+#endif
+#if defined(CONFIG_CANARD_MOVABLE_ADDONS)
+#include <dinosaurs/peripheral/MovableAddons_1_0.h>
+#endif
+#if defined(CONFIG_CANARD_ELEVATOR)
+#include <stdlib.h>
+#endif
+#if defined(CONFIG_CANARD_ELEVATOR) || defined(CONFIG_CANARD_MOVABLE_ADDONS)
+#include "elevator_if.h"
+#endif
+#include "canard_time.h"
+#include "canard_sched.h"
+#include "canard_health.h"
+#if defined(CONFIG_CANARD_TELEMETRY)
+#include "canard_telemetry.h"
+#endif
+#if defined(CONFIG_CANARD_TX_GOVERNOR)
+#include "canard_load.h"
+#endif
+#if defined(CONFIG_CANARD_SCOPE)
+#include "canard_scope.h"
+#endif
+#if defined(CONFIG_CANARD_BLACKBOX)
+#include "canard_blackbox.h"
+#endif
+#if defined(CONFIG_PID_AUTOTUNE)
+#include "pid_autotune.h"
+#endif
+#if defined(CONFIG_CANARD_REGISTER)
+#include <uavcan/_register/Access_1_0.h>
+#include <uavcan/_register/List_1_0.h>
+#include "canard_register.h"
+#endif
+#include "../stm32_can.h"
+#include "log_rl.h"
+LOG_MODULE_REGISTER(canard_if, LOG_LEVEL_INF);
+
+/* SetTargetValue 请求: 标准字段之后可追加 7 字节生效时间 */
+#define SET_TARGET_REQUEST_EXTENT 16U
+
+/*
+ * libcanard 堆的内存预算, 由启用的订阅, 发布与发送队列在编译期算出:
+ *   RX: 每个订阅最多 CONFIG_CANARD_RX_SESSIONS 个远端节点(组状态为
+ *       CONFIG_ELEVATOR_GROUP_MAX_NODES 个组员), 每个节点一个会话
+ *       (首次收到后常驻) 和一个 extent 大小的重组缓冲;
+ *   TX: 每个接口 CANARD_TX_QUEUE_CAPACITY 帧, 每帧一次分配(队列项 + MTU).
+ * 每次分配按 sys_heap 的 8 字节块加块头取整, 再加碎片余量与堆自身的元数据.
+ * 配置不足时编译失败, 而不是在现场 canardRxAccept/canardTxPush 返回 OOM.
+ */
+#define CANARD_BUDGET_CHUNK(n)        ROUND_UP((n) + 4U, 8U)   // sys_heap 小堆的块头 4 字节
+#define CANARD_BUDGET_RX_SESSION      32U                      // libcanard v3 内部 RxSession, 32 位目标
+#define CANARD_BUDGET_HEAP_OVERHEAD   128U                     // struct z_heap 与空闲桶
+#define CANARD_BUDGET_RX_NODES(nodes, extent)                                     \
+    ((nodes) * (CANARD_BUDGET_CHUNK(CANARD_BUDGET_RX_SESSION) + CANARD_BUDGET_CHUNK(extent)))
+#define CANARD_BUDGET_RX_SUB(extent) CANARD_BUDGET_RX_NODES(CONFIG_CANARD_RX_SESSIONS, extent)
+/* 一个传输占用的帧数: 单帧不带 CRC, 多帧每帧 1 字节尾字节且末尾追加 2 字节 CRC */
+#define CANARD_BUDGET_FRAMES(size) \
+    (((size) < CAN_IFACE_MTU) ? 1U : DIV_ROUND_UP((size) + 2U, CAN_IFACE_MTU - 1U))
+
+/* 每个成员对应一个订阅, sizeof 即全部订阅的 RX 堆需求 */
+struct canard_rx_budget {
+#if defined(CONFIG_CANARD_SERVICE_ENABLE)
+    uint8_t enable[CANARD_BUDGET_RX_SUB(dinosaurs_actuator_wheel_motor_Enable_Request_1_0_EXTENT_BYTES_)];
+#endif
+#if defined(CONFIG_CANARD_SERVICE_SET_TARGET)
+    uint8_t set_target[CANARD_BUDGET_RX_SUB(SET_TARGET_REQUEST_EXTENT)];
+#endif
+#if defined(CONFIG_CANARD_SERVICE_PID_PARAMETER)
+    uint8_t pid_parameter[CANARD_BUDGET_RX_SUB(dinosaurs_actuator_wheel_motor_PidParameter_Request_1_0_EXTENT_BYTES_)];
+#endif
+#if defined(CONFIG_CANARD_SERVICE_SET_MODE)
+    uint8_t set_mode[CANARD_BUDGET_RX_SUB(dinosaurs_actuator_wheel_motor_SetMode_Request_2_0_EXTENT_BYTES_)];
+#endif
+#if defined(CONFIG_CANARD_SERVICE_OPERATE_REMOTE_DEVICE)
+    uint8_t operate[CANARD_BUDGET_RX_SUB(dinosaurs_peripheral_OperateRemoteDevice_Request_1_0_EXTENT_BYTES_)];
+#endif
+    uint8_t time_sync[CANARD_BUDGET_RX_SUB(CANARD_TIME_SYNC_EXTENT)];
+#if defined(CONFIG_ELEVATOR_GROUP)
+    uint8_t group[CANARD_BUDGET_RX_NODES(CONFIG_ELEVATOR_GROUP_MAX_NODES, ELEVATOR_GROUP_STATUS_SIZE)];
+#endif
+#if defined(CONFIG_CANARD_SCOPE)
+    uint8_t scope[CANARD_BUDGET_RX_SUB(CANARD_SCOPE_REQUEST_EXTENT)];
+#endif
+#if defined(CONFIG_CANARD_BLACKBOX)
+    uint8_t blackbox[CANARD_BUDGET_RX_SUB(CANARD_BLACKBOX_REQUEST_EXTENT)];
+#endif
+#if defined(CONFIG_PID_AUTOTUNE)
+    uint8_t autotune[CANARD_BUDGET_RX_SUB(PID_AUTOTUNE_REQUEST_EXTENT)];
+#endif
+#if defined(CONFIG_CANARD_REGISTER)
+    uint8_t register_access[CANARD_BUDGET_RX_SUB(uavcan_register_Access_Request_1_0_EXTENT_BYTES_)];
+    uint8_t register_list[CANARD_BUDGET_RX_SUB(uavcan_register_List_Request_1_0_EXTENT_BYTES_)];
+#endif
+};
+
+/* 每个成员对应一种发出的传输, sizeof 即最长的一个 */
+union canard_tx_budget {
+    uint8_t heartbeat[7];
+#if defined(CONFIG_CANARD_MOVABLE_ADDONS)
+    uint8_t movable_addons[dinosaurs_peripheral_MovableAddons_1_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+#endif
+#if defined(CONFIG_CANARD_SERVICE_ENABLE)
+    uint8_t enable[dinosaurs_actuator_wheel_motor_Enable_Response_1_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+#endif
+#if defined(CONFIG_CANARD_SERVICE_SET_TARGET)
+    uint8_t set_target[dinosaurs_actuator_wheel_motor_SetTargetValue_Response_2_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+#endif
+#if defined(CONFIG_CANARD_SERVICE_PID_PARAMETER)
+    uint8_t pid_parameter[dinosaurs_actuator_wheel_motor_PidParameter_Response_1_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+#endif
+#if defined(CONFIG_CANARD_SERVICE_SET_MODE)
+    uint8_t set_mode[dinosaurs_actuator_wheel_motor_SetMode_Response_2_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+#endif
+#if defined(CONFIG_CANARD_SERVICE_OPERATE_REMOTE_DEVICE)
+    uint8_t operate[dinosaurs_peripheral_OperateRemoteDevice_Response_1_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+#endif
+#if defined(CONFIG_ELEVATOR_GROUP)
+    uint8_t group[ELEVATOR_GROUP_STATUS_SIZE];
+#endif
+#if defined(CONFIG_CANARD_TX_GOVERNOR)
+    uint8_t load[CANARD_LOAD_STATUS_SIZE];
+#endif
+#if defined(CONFIG_CANARD_HEALTH)
+    uint8_t health[CANARD_HEALTH_STATUS_SIZE];
+#endif
+#if defined(CONFIG_CANARD_TELEMETRY)
+    uint8_t telemetry[CANARD_TELEMETRY_MAX_SIZE];
+#endif
+#if defined(CONFIG_CANARD_SCOPE)
+    uint8_t scope[CONFIG_CANARD_SCOPE_CHUNK_BYTES];
+#endif
+#if defined(CONFIG_CANARD_BLACKBOX)
+    uint8_t blackbox[CANARD_BLACKBOX_RESPONSE_MAX];
+#endif
+#if defined(CONFIG_PID_AUTOTUNE)
+    uint8_t autotune[PID_AUTOTUNE_RESULT_SIZE];
+#endif
+#if defined(CONFIG_CANARD_REGISTER)
+    uint8_t register_access[uavcan_register_Access_Response_1_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+    uint8_t register_list[uavcan_register_List_Response_1_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+#endif
+};
+
+#define CANARD_TX_MAX_FRAMES CANARD_BUDGET_FRAMES(sizeof(union canard_tx_budget))
+#if CONFIG_CANARD_TX_QUEUE_CAPACITY > 0
+#define CANARD_TX_QUEUE_CAPACITY CONFIG_CANARD_TX_QUEUE_CAPACITY
+#else
+/* 最长的传输, 再加上它发送期间排在后面的周期发布与另一个应答 */
+#define CANARD_TX_QUEUE_CAPACITY (2U * CANARD_TX_MAX_FRAMES)
+#endif
+BUILD_ASSERT(CANARD_TX_QUEUE_CAPACITY >= CANARD_TX_MAX_FRAMES,
+             "CANARD_TX_QUEUE_CAPACITY cannot hold the longest transfer");
+
+#define CANARD_RX_HEAP_NEED sizeof(struct canard_rx_budget)
+#define CANARD_TX_HEAP_NEED                                                   \
+    (CAN_IFACE_COUNT * CANARD_TX_QUEUE_CAPACITY *                             \
+     CANARD_BUDGET_CHUNK(sizeof(CanardTxQueueItem) + CAN_IFACE_MTU))
+#define CANARD_HEAP_NEED                                                              \
+    ((CANARD_RX_HEAP_NEED + CANARD_TX_HEAP_NEED) * (100U + CONFIG_CANARD_HEAP_MARGIN_PERCENT) / 100U + \
+     CANARD_BUDGET_HEAP_OVERHEAD)
+#if CONFIG_CANARD_HEAP_SIZE > 0
+#define CANARD_MEM_POOL_SIZE CONFIG_CANARD_HEAP_SIZE
+BUILD_ASSERT(CONFIG_CANARD_HEAP_SIZE >= CANARD_HEAP_NEED,
+             "CONFIG_CANARD_HEAP_SIZE is below the computed worst case of the configured services");
+#else
+#define CANARD_MEM_POOL_SIZE ROUND_UP(CANARD_HEAP_NEED, 8U)
+#endif
+static uint8_t APP_HOT_BSS canard_mem_pool[CANARD_MEM_POOL_SIZE] __aligned(8);// 静态内存池定义
+
+/*
+ * 线程栈: 处理函数在栈上放请求结构, 应答结构和序列化缓冲, 三者都不超过最长的传输.
+ * 这里只拦住明显不够的配置, 实际余量用 CONFIG_THREAD_ANALYZER 测.
+ */
+BUILD_ASSERT(CONFIG_CANARD_THREAD_STACK_SIZE >= 1024U + 3U * sizeof(union canard_tx_budget),
+             "CONFIG_CANARD_THREAD_STACK_SIZE too small for the largest transfer");
+#if defined(CONFIG_APP_CYCLE_STATS)
+static struct cycle_stats canard_rx_cycles;
+#endif
+static struct k_heap canard_heap;
+static CanardInstance canard;
+static CanardTxQueue txQueue[CAN_IFACE_COUNT];  // 冗余模式下每个接口一条发送队列
+K_THREAD_STACK_DEFINE(canard_thread_stack, CONFIG_CANARD_THREAD_STACK_SIZE);
+static struct k_thread thread;         ///< 线程控制块
+static uint8_t heartbeat_transfer_id = 0;
+#if defined(CONFIG_CANARD_MOVABLE_ADDONS)
+static uint8_t movable_addons_transfer_id = 0;
+static const CanardPortID MOVABLE_ADDONS_PORT_ID = 1022;     // 为MovableAddons分配的端口ID
+#endif
+#if defined(CONFIG_CANARD_ELEVATOR)
+static uint32_t last_movable_seq = 0;
+#endif
+
+static void subscribe_services(void);
+#if defined(CONFIG_CANARD_SERVICE_ENABLE)
+static void handle_motor_enable(CanardRxTransfer* transfer);
+#endif
+#if defined(CONFIG_CANARD_SERVICE_SET_TARGET)
+static void handle_set_targe(CanardRxTransfer* transfer);
+#endif
+#if defined(CONFIG_CANARD_SERVICE_PID_PARAMETER)
+static void handle_pid_parameter(CanardRxTransfer* transfer);
+#endif
+#if defined(CONFIG_CANARD_SERVICE_SET_MODE)
+static void handle_set_mode(CanardRxTransfer* transfer);
+#endif
+#if defined(CONFIG_CANARD_SERVICE_OPERATE_REMOTE_DEVICE)
+static void handle_operate_remote_device(CanardRxTransfer* transfer); // 新增操作远程设备回调
+#endif
+static void handle_time_sync(CanardRxTransfer* transfer);
+#if defined(CONFIG_CANARD_SCOPE)
+static void handle_scope(CanardRxTransfer* transfer);
+#endif
+#if defined(CONFIG_CANARD_BLACKBOX)
+static void handle_blackbox(CanardRxTransfer* transfer);
+#endif
+#if defined(CONFIG_PID_AUTOTUNE)
+static void handle_autotune(CanardRxTransfer* transfer);
+static void autotune_poll_completion(void);
+#endif
+#if defined(CONFIG_CANARD_REGISTER)
+static void registers_init(void);
+static void handle_register_access(CanardRxTransfer* transfer);
+static void handle_register_list(CanardRxTransfer* transfer);
+#endif
+#if defined(CONFIG_ELEVATOR_GROUP)
+static void handle_group_status(CanardRxTransfer* transfer);
+static uint8_t group_status_transfer_id = 0;
+#endif
+
+typedef void (*canard_subscription_callback_t)(CanardRxTransfer*);
+
+#define NODE_ID CONFIG_CANARD_NODE_ID   // 默认节点号, 寄存器 uavcan.node.id 重启后生效
+#define SERVICE_ID_ENABLE      113
+#define SERVICE_ID_SET_TARGET  117
+#define SERVICE_ID_OPERATE_REMOTE_DEVICE 121
+
+static uint16_t node_id = NODE_ID;
+
+/*
+ * Cyphal CAN ID: bit28..26 优先级, bit25 服务帧, bit24 请求,
+ * bit22..14 服务号, bit13..7 目的节点.
+ * 以下帧走高优先级接收队列, 不会被低优先级的诊断流量阻塞.
+ * 启用的命令服务在前, 其目的节点在 canard_thread 启动时填入.
+ */
+#define CYPHAL_REQUEST_FILTER(service_id, node_id) {                              \
+    .id = BIT(25) | BIT(24) | ((uint32_t)(service_id) << 14) | ((uint32_t)(node_id) << 7), \
+    .mask = BIT(25) | BIT(24) | (0x1FFU << 14) | (0x7FU << 7),                   \
+    .flags = CAN_FILTER_IDE                                                      \
+}
+static struct can_filter critical_filters[] = {
+#if defined(CONFIG_CANARD_SERVICE_SET_TARGET)
+    CYPHAL_REQUEST_FILTER(SERVICE_ID_SET_TARGET, 0),
+#endif
+#if defined(CONFIG_CANARD_SERVICE_ENABLE)
+    CYPHAL_REQUEST_FILTER(SERVICE_ID_ENABLE, 0),
+#endif
+    { .id = 0x0U << 26, .mask = 0x6U << 26, .flags = CAN_FILTER_IDE },  // Exceptional/Immediate
+    { .id = 0x2U << 26, .mask = 0x7U << 26, .flags = CAN_FILTER_IDE },  // Fast
+};
+#define CRITICAL_REQUEST_FILTERS (ARRAY_SIZE(critical_filters) - 2U)
+
+/* 每轮最多处理的普通帧数, 之间穿插检查高优先级队列; 一个轮询间隔内最多到达这么多帧 */
+#define RX_LOW_BUDGET CAN_RX_BURST
+
+/* 发送帧的有效期, 过期未发出(邮箱一直满或总线故障)的帧直接丢弃 */
+#define CANARD_TX_DEADLINE_USEC 100000U
+
+/* 接收到处理的延迟统计(微秒), 从中断时间戳算起, 按接口分别统计 */
+struct canard_rx_latency {
+    uint32_t last;
+    uint32_t max;
+    uint32_t avg;        // 指数滑动平均, 1/16
+    uint32_t count;
+};
+static struct canard_rx_latency rx_latency[CAN_IFACE_COUNT];
+
+const struct canard_rx_latency* canard_if_rx_latency(uint8_t iface)
+{
+    return (iface < CAN_IFACE_COUNT) ? &rx_latency[iface] : NULL;
+}
+
+/*
+ * 启动耗时, 自内核启动起的毫秒数(不含 ROM 引导与内核前的驱动初始化),
+ * 0 表示尚未发生. 记录一次后经日志, 黑匣子和寄存器报告.
+ */
+enum boot_milestone {
+    BOOT_CAN_UP = 0,
+    BOOT_FIRST_HEARTBEAT,
+    BOOT_FIRST_COMMAND,
+    BOOT_MILESTONES
+};
+static uint32_t boot_ms[BOOT_MILESTONES];
+
+static void boot_milestone(uint8_t id)
+{
+    static const char* const names[BOOT_MILESTONES] = { "CAN up", "first heartbeat", "first command" };
+
+    if (boot_ms[id] != 0U) {
+        return;
+    }
+    boot_ms[id] = MAX(k_uptime_get_32(), 1U);
+    LOG_INF("Boot: %s after %u ms", names[id], boot_ms[id]);
+#if defined(CONFIG_CANARD_BLACKBOX)
+    canard_blackbox_record(CANARD_BLACKBOX_BOOT_TIMING, id, (uint16_t)MIN(boot_ms[id], UINT16_MAX));
+#endif
+}
+
+static bool is_command_service(CanardPortID port_id)
+{
+    return port_id == SERVICE_ID_SET_TARGET || port_id == SERVICE_ID_ENABLE ||
+           port_id == SERVICE_ID_OPERATE_REMOTE_DEVICE;
+}
+
+static void rx_latency_update(uint8_t iface, CanardMicrosecond rx_usec)
+{
+    struct canard_rx_latency* st = &rx_latency[iface];
+    const uint64_t now = canard_time_local_usec();
+    const uint32_t lat = (now > rx_usec) ? (uint32_t)MIN(now - rx_usec, UINT32_MAX) : 0U;
+
+    st->last = lat;
+    st->max = MAX(st->max, lat);
+    st->avg = (st->count == 0U) ? lat :
+              st->avg + (int32_t)(lat - st->avg) / 16;
+    st->count++;
+}
+
+static void* memAllocate(CanardInstance* const ins, size_t amount)
+{
+    (void)ins;
+    void* ptr = k_heap_alloc(&canard_heap, amount, K_NO_WAIT);
+
+    if (ptr == NULL) {
+        canard_health_heap_oom();   // libcanard 只丢弃传输, 不会上报
+    }
+    return ptr; // 使用Zephyr内存分配
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void)ins;
+    k_heap_free(&canard_heap, pointer);
+}
+
+int canard_if_init(uint8_t node_id)
+{
+    k_heap_init(&canard_heap, canard_mem_pool, sizeof(canard_mem_pool));
+    canard = canardInit(&memAllocate, &memFree);
+    canard.node_id = node_id;
+    for (uint8_t i = 0; i < CAN_IFACE_COUNT; i++) {
+        txQueue[i] = canardTxInit(CANARD_TX_QUEUE_CAPACITY, CAN_IFACE_MTU);
+    }
+#if defined(CONFIG_CANARD_HEALTH)
+    canard_health_init(&canard_heap.heap, CANARD_TX_QUEUE_CAPACITY);
+#endif
+    LOG_INF("Heap %u bytes (rx %u tx %u), tx queue %u frames", (unsigned)sizeof(canard_mem_pool),
+            (unsigned)CANARD_RX_HEAP_NEED, (unsigned)CANARD_TX_HEAP_NEED, (unsigned)CANARD_TX_QUEUE_CAPACITY);
+    return 0;
+}
+
+/*
+ * 把一个传输推入所有接口的发送队列. 冗余模式下同一传输在两条总线上各发一次,
+ * 接收端按 transfer-ID 去重. 返回成功入队的接口数, 超出发送预算时返回 -EBUSY.
+ */
+static int canard_if_push(const CanardTransferMetadata* meta, size_t payload_size, const void* payload)
+{
+    const CanardMicrosecond deadline = canard_time_local_usec() + CANARD_TX_DEADLINE_USEC;
+    int pushed = 0;
+
+#if defined(CONFIG_CANARD_TX_GOVERNOR)
+    // 只限制消息, 服务响应总是放行
+    if (!canard_load_admit(meta->priority, meta->transfer_kind == CanardTransferKindMessage, payload_size)) {
+        return -EBUSY;
+    }
+#endif
+
+    for (uint8_t i = 0; i < CAN_IFACE_COUNT; i++) {
+        const int32_t ret = canardTxPush(&txQueue[i], &canard, deadline, meta, payload_size, payload);
+
+        canard_health_tx_push(ret, txQueue[i].size);
+        if (ret > 0) {
+            pushed++;
+        } else {
+            can_iface_stats[i].tx_drop++;
+        }
+    }
+    return pushed;
+}
+
+static int32_t canard_transmit(uint8_t iface, const CanardTxQueueItem* ti)
+{
+    struct can_frame frame = {
+        .id = ti->frame.extended_can_id,
+        .dlc = can_bytes_to_dlc(ti->frame.payload_size),
+#if defined(CONFIG_CANARD_FD)
+        .flags = CAN_FRAME_IDE | CAN_FRAME_FDF | CAN_FRAME_BRS
+#else
+        .flags = CAN_FRAME_IDE
+#endif
+    };
+    memcpy(frame.data, ti->frame.payload, ti->frame.payload_size);
+    return can_iface_send(iface, &frame);
+}
+
+/* 各接口独立发送, 一条总线故障或拥塞不会阻塞另一条 */
+static void canard_tx_service(void)
+{
+    const CanardMicrosecond now = canard_time_local_usec();
+
+    for (uint8_t i = 0; i < CAN_IFACE_COUNT; i++) {
+        uint16_t dropped = 0;
+
+        for (const CanardTxQueueItem* ti = NULL; (ti = canardTxPeek(&txQueue[i])) != NULL;) {
+            int32_t ret = -ETIMEDOUT;
+            if (ti->tx_deadline_usec >= now) {
+                ret = canard_transmit(i, ti);
+            }
+            if (ret == -EAGAIN) {
+                break;  // 邮箱满, 下一轮再发
+            }
+            if (ret != 0) {
+                can_iface_stats[i].tx_drop++;
+                dropped++;
+            }
+            canard.memory_free(&canard, canardTxPop(&txQueue[i], ti));
+        }
+#if defined(CONFIG_CANARD_BLACKBOX)
+        if (dropped != 0U) {
+            canard_blackbox_record(CANARD_BLACKBOX_TX_DROP, i, dropped);
+        }
+#endif
+    }
+}
+
+
+bool canard_publish_heartbeat(void)
+{
+    {{ 
+    const uint64_t uptime_sec = k_uptime_get() / 1000;
+    uint8_t vendor;
+    const uint8_t health = canard_health_heartbeat(&vendor);
+    uint8_t heartbeat_payload[7] = {
+        (uint8_t)(uptime_sec & 0xFF),
+        (uint8_t)((uptime_sec >> 8) & 0xFF),
+        (uint8_t)((uptime_sec >> 16) & 0xFF),
+        (uint8_t)((uptime_sec >> 24) & 0xFF),
+        health,  // Health状态, 堆或队列接近上限时为 ADVISORY
+        0x3F,  // Mode状态 (OPERATIONAL)
+        vendor   // Vendor-specific状态, CANARD_HEALTH_FLAG_*
+    };
+
+    const CanardTransferMetadata metadata = {
+        .priority       = CanardPriorityNominal,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = 7509,  // UAVCAN.node.Heartbeat标准端口
+        .remote_node_id = CANARD_NODE_ID_UNSET,
+        .transfer_id    = heartbeat_transfer_id++,
+    };
+
+    return canard_if_push(&metadata, sizeof(heartbeat_payload), heartbeat_payload) > 0;
+    }}
+}
+
+#if defined(CONFIG_CANARD_MOVABLE_ADDONS)
+bool canard_publish_movable_addons(uint16_t device_id, const char* device_name, uint8_t state_value)
+{
+    // 初始化MovableAddons消息
+    dinosaurs_peripheral_MovableAddons_1_0 msg = {
+        .state = {
+            .timestamp = {
+                .microsecond = canard_time_sync_usec() // 总线同步时间（微秒）
+            },
+            .current_state = state_value
+        },
+        .device_id = device_id
+    };
+    
+    // 设置设备名称
+    size_t name_len = strlen(device_name);
+    if (name_len > uavcan_primitive_String_1_0_value_ARRAY_CAPACITY_) {
+        name_len = uavcan_primitive_String_1_0_value_ARRAY_CAPACITY_;
+    }
+    msg.name.value.count = name_len;
+    memcpy(msg.name.value.elements, device_name, name_len);
+    
+    // 序列化消息
+    uint8_t buffer[dinosaurs_peripheral_MovableAddons_1_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+    size_t buffer_size = sizeof(buffer);
+    int8_t ret = dinosaurs_peripheral_MovableAddons_1_0_serialize_(&msg, buffer, &buffer_size);
+    
+    if (ret < 0) {
+        LOG_ERR("MovableAddons serialization failed: %d", ret);
+        return false;
+    }
+    
+    // 设置传输元数据
+    const CanardTransferMetadata metadata = {
+        .priority       = CanardPriorityNominal,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = MOVABLE_ADDONS_PORT_ID,
+        .remote_node_id = CANARD_NODE_ID_UNSET,
+        .transfer_id    = movable_addons_transfer_id++
+    };
+    
+    // 推送到发送队列
+    return canard_if_push(&metadata, buffer_size, buffer) > 0;
+}
+#endif
+
+#if defined(CONFIG_ELEVATOR_GROUP)
+// 成组顶升状态广播, 控制关键数据, 使用高优先级
+static void canard_publish_group_status(void)
+{
+    uint8_t buffer[ELEVATOR_GROUP_STATUS_SIZE];
+    size_t buffer_size = elevator_group_encode(buffer, sizeof(buffer));
+
+    const CanardTransferMetadata metadata = {
+        .priority       = CanardPriorityHigh,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = CONFIG_ELEVATOR_GROUP_PORT_ID,
+        .remote_node_id = CANARD_NODE_ID_UNSET,
+        .transfer_id    = group_status_transfer_id++
+    };
+    canard_if_push(&metadata, buffer_size, buffer);
+}
+
+static void handle_group_status(CanardRxTransfer* transfer)
+{
+    elevator_group_decode(transfer->metadata.remote_node_id,
+                          transfer->payload, transfer->payload_size);
+}
+#endif
+
+#if defined(CONFIG_CANARD_ELEVATOR)
+static void elevator_poll_completions(void);
+#endif
+
+#if defined(CONFIG_CANARD_TX_GOVERNOR)
+static uint8_t bus_load_transfer_id = 0;
+
+static bool canard_publish_bus_load(void)
+{
+    uint8_t buffer[CANARD_LOAD_STATUS_SIZE];
+
+    canard_load_encode(buffer);
+    const CanardTransferMetadata metadata = {
+        .priority       = CanardPriorityLow,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = CONFIG_CANARD_BUS_LOAD_PORT_ID,
+        .remote_node_id = CANARD_NODE_ID_UNSET,
+        .transfer_id    = bus_load_transfer_id++
+    };
+    return canard_if_push(&metadata, sizeof(buffer), buffer) > 0;
+}
+#endif
+
+#if defined(CONFIG_CANARD_TELEMETRY)
+static uint8_t telemetry_transfer_id = 0;
+
+static bool canard_publish_telemetry(void)
+{
+    uint8_t buffer[CANARD_TELEMETRY_MAX_SIZE];
+    const size_t len = canard_telemetry_encode(buffer, sizeof(buffer));
+
+    if (len == 0U) {
+        return true;    // 没有新样本, 等下一周期
+    }
+    const CanardTransferMetadata metadata = {
+        .priority       = CanardPriorityLow,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = CONFIG_CANARD_TELEMETRY_PORT_ID,
+        .remote_node_id = CANARD_NODE_ID_UNSET,
+        .transfer_id    = telemetry_transfer_id
+    };
+    // 被发送预算拒绝时保留这一批, 调度器下一毫秒重试
+    if (canard_if_push(&metadata, len, buffer) <= 0) {
+        return false;
+    }
+    telemetry_transfer_id++;
+    canard_telemetry_sent();
+    return true;
+}
+#endif
+
+#if defined(CONFIG_CANARD_HEALTH)
+static uint8_t health_transfer_id = 0;
+
+static bool canard_publish_health(void)
+{
+    uint8_t buffer[CANARD_HEALTH_STATUS_SIZE];
+
+    canard_health_encode(buffer);
+    const CanardTransferMetadata metadata = {
+        .priority       = CanardPriorityLow,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = CONFIG_CANARD_HEALTH_PORT_ID,
+        .remote_node_id = CANARD_NODE_ID_UNSET,
+        .transfer_id    = health_transfer_id++
+    };
+    return canard_if_push(&metadata, sizeof(buffer), buffer) > 0;
+}
+#endif
+
+static APP_HOT_TEXT void canard_process_rx(const struct can_rx_item* item)
+{
+    CanardFrame canard_frame = {
+        .extended_can_id = item->frame.id,
+        .payload_size = can_dlc_to_bytes(item->frame.dlc),
+        .payload = item->frame.data
+    };
+
+    CanardRxTransfer transfer;
+    CanardRxSubscription* subscription = NULL;
+
+#if defined(CONFIG_APP_CYCLE_STATS)
+    const uint32_t start = k_cycle_get_32();
+#endif
+    // 使用中断中锁存的接收时间, 传输超时与时间同步都以此为准
+    const int8_t accepted = canardRxAccept(&canard, canard_time_from_cycles(item->rx_cycles),
+                                           &canard_frame, item->iface, &transfer, &subscription);
+#if defined(CONFIG_APP_CYCLE_STATS)
+    cycle_stats_add(&canard_rx_cycles, start);
+#endif
+    canard_health_rx_accept(accepted, subscription, &transfer);
+    if (accepted > 0)
+    {
+#if defined(CONFIG_CANARD_BLACKBOX)
+        if (transfer.metadata.transfer_kind == CanardTransferKindRequest) {
+            canard_blackbox_record(CANARD_BLACKBOX_RX_REQUEST, transfer.metadata.remote_node_id,
+                                   transfer.metadata.port_id);
+        }
+#endif
+        if (subscription && subscription->user_reference) {
+            canard_subscription_callback_t callback =
+                (canard_subscription_callback_t)subscription->user_reference;
+            callback(&transfer);
+        }
+        if (transfer.metadata.transfer_kind == CanardTransferKindRequest &&
+            is_command_service(transfer.metadata.port_id)) {
+            boot_milestone(BOOT_FIRST_COMMAND);
+        }
+        rx_latency_update(item->iface, transfer.timestamp_usec);
+        canard.memory_free(&canard, transfer.payload);
+    }
+}
+
+static bool sched_heartbeat(void* arg)
+{
+    ARG_UNUSED(arg);
+    const bool sent = canard_publish_heartbeat();
+
+    if (sent) {
+        boot_milestone(BOOT_FIRST_HEARTBEAT);
+    }
+    return sent;
+}
+
+static struct canard_sched_entry heartbeat_pub =
+    CANARD_SCHED_ENTRY("heartbeat", sched_heartbeat, NULL, 1000, CANARD_SCHED_PHASE_AUTO);
+
+#if defined(CONFIG_CANARD_MOVABLE_ADDONS)
+static bool sched_movable_addons(void* arg)
+{
+    ARG_UNUSED(arg);
+    return canard_publish_movable_addons(1, "ieb_motor_lift", super_elevator_state());
+}
+
+static struct canard_sched_entry movable_addons_pub =
+    CANARD_SCHED_ENTRY("movable_addons", sched_movable_addons, NULL, CONFIG_CANARD_MOVABLE_ADDONS_PERIOD_MS, CANARD_SCHED_PHASE_AUTO);
+static uint16_t movable_addons_period_ms = CONFIG_CANARD_MOVABLE_ADDONS_PERIOD_MS;
+#endif
+
+#if defined(CONFIG_CANARD_TX_GOVERNOR)
+static bool sched_bus_load(void* arg)
+{
+    ARG_UNUSED(arg);
+    return canard_publish_bus_load();
+}
+
+static struct canard_sched_entry bus_load_pub =
+    CANARD_SCHED_ENTRY("bus_load", sched_bus_load, NULL, CONFIG_CANARD_BUS_LOAD_PUB_MS, CANARD_SCHED_PHASE_AUTO);
+#endif
+
+#if defined(CONFIG_ELEVATOR_GROUP)
+/* 运动中加快广播, 周期在每次发布后更新 */
+static bool sched_group_status(void* arg)
+{
+    canard_publish_group_status();
+    canard_sched_set_period(arg, elevator_group_period_ms());
+    return true;
+}
+
+static struct canard_sched_entry group_status_pub =
+    CANARD_SCHED_ENTRY("group_status", sched_group_status, &group_status_pub,
+                       CONFIG_ELEVATOR_GROUP_PERIOD_MS, CANARD_SCHED_PHASE_AUTO);
+#endif
+
+#if defined(CONFIG_CANARD_TELEMETRY)
+static bool sched_telemetry(void* arg)
+{
+    ARG_UNUSED(arg);
+    return canard_publish_telemetry();
+}
+
+static struct canard_sched_entry telemetry_pub =
+    CANARD_SCHED_ENTRY("telemetry", sched_telemetry, NULL, CANARD_TELEMETRY_PERIOD_MS, CANARD_SCHED_PHASE_AUTO);
+#endif
+
+#if defined(CONFIG_CANARD_HEALTH)
+static bool sched_health(void* arg)
+{
+    ARG_UNUSED(arg);
+    return canard_publish_health();
+}
+
+static struct canard_sched_entry health_pub =
+    CANARD_SCHED_ENTRY("health", sched_health, NULL, CONFIG_CANARD_HEALTH_PUB_MS, CANARD_SCHED_PHASE_AUTO);
+#endif
+
+#if defined(CONFIG_APP_CYCLE_STATS)
+extern struct cycle_stats motor_loop_cycles;
+
+static void cycle_stats_log(const char* name, struct cycle_stats* st)
+{
+    // 与累加方并发清零, 最多丢失一个样本, 对统计无碍
+    LOG_INF("cycles %s: avg %u max %u n %u", name, st->avg, st->max, st->n);
+    st->max = 0;
+    st->n = 0;
+}
+
+static bool sched_cycle_stats(void* arg)
+{
+    ARG_UNUSED(arg);
+    cycle_stats_log("can_rx_isr", &can_rx_isr_cycles);
+    cycle_stats_log("canard_rx", &canard_rx_cycles);
+    cycle_stats_log("motor_loop", &motor_loop_cycles);
+    return true;
+}
+
+static struct canard_sched_entry cycle_stats_log_entry =
+    CANARD_SCHED_ENTRY("cycle_stats", sched_cycle_stats, NULL, CONFIG_APP_CYCLE_STATS_PERIOD_MS, CANARD_SCHED_PHASE_AUTO);
+#endif
+
+static void schedule_publications(void)
+{
+    canard_sched_add(&heartbeat_pub);
+#if defined(CONFIG_CANARD_MOVABLE_ADDONS)
+    canard_sched_add(&movable_addons_pub);
+#endif
+#if defined(CONFIG_CANARD_TX_GOVERNOR)
+    canard_sched_add(&bus_load_pub);
+#endif
+#if defined(CONFIG_CANARD_TELEMETRY)
+    canard_sched_add(&telemetry_pub);
+#endif
+#if defined(CONFIG_CANARD_HEALTH)
+    canard_sched_add(&health_pub);
+#endif
+#if defined(CONFIG_ELEVATOR_GROUP)
+    canard_sched_add(&group_status_pub);
+#endif
+#if defined(CONFIG_APP_CYCLE_STATS)
+    canard_sched_add(&cycle_stats_log_entry);
+#endif
+}
+
+static void canard_thread(void *p1, void *p2, void *p3)
+{
+#if defined(CONFIG_CANARD_REGISTER)
+    // 节点号与波特率可能被存储的寄存器覆盖, 必须在 can_init 之前恢复
+    registers_init();
+#endif
+    for (size_t i = 0; i < CRITICAL_REQUEST_FILTERS; i++) {
+        critical_filters[i].id |= (uint32_t)node_id << 7;
+    }
+    if (can_init(critical_filters, ARRAY_SIZE(critical_filters)) == 0) {
+        boot_milestone(BOOT_CAN_UP);
+    }
+    canard_if_init((uint8_t)node_id);
+    subscribe_services();  // 新增服务订阅
+#if defined(CONFIG_ELEVATOR_GROUP)
+    elevator_group_init((uint8_t)node_id);
+#endif
+    schedule_publications();
+
+    while(1)
+    {
+        // 处理发送队列
+        canard_tx_service();
+#if defined(CONFIG_CANARD_TX_GOVERNOR)
+        canard_load_update();
+#endif
+#if defined(CONFIG_CANARD_BLACKBOX)
+        canard_blackbox_poll();
+#endif
+#if defined(CONFIG_PID_AUTOTUNE)
+        autotune_poll_completion();
+#endif
+#if defined(CONFIG_CANARD_ELEVATOR)
+        elevator_poll_completions();
+
+        // 状态变化时立即发布, 否则按慢速周期刷新
+        const uint32_t movable_seq = super_elevator_state_seq();
+        if (movable_seq != last_movable_seq) {
+            last_movable_seq = movable_seq;
+            canard_sched_kick(&movable_addons_pub);
+        }
+#endif
+        canard_sched_poll();
+
+        // 新增接收处理: 先清空高优先级队列, 普通帧按预算处理
+        struct can_rx_item item;
+        for (int budget = RX_LOW_BUDGET;;) {
+            if (k_msgq_get(&rx_msgq_hi, &item, K_NO_WAIT) == 0) {
+                canard_process_rx(&item);
+            } else if (budget > 0 && k_msgq_get(&rx_msgq, &item, K_NO_WAIT) == 0) {
+                budget--;
+                canard_process_rx(&item);
+            } else {
+                break;
+            }
+        }
+        k_msleep(CAN_RX_POLL_MS);
+    }
+}
+
+void creat_canard_thread(void)
+{
+    k_thread_create(&thread,
+        canard_thread_stack,
+        K_THREAD_STACK_SIZEOF(canard_thread_stack),
+        canard_thread,
+        NULL,
+        NULL,
+        NULL,
+        K_PRIO_COOP(4),  // 高优先级协作线程
+        0,
+        K_NO_WAIT);    
+}
+
+
+// 订阅服务函数
+static void subscribe_services(void)
+{
+#if defined(CONFIG_CANARD_SERVICE_ENABLE)
+    static CanardRxSubscription sub_enable;
+
+    sub_enable.user_reference = (void*)handle_motor_enable; // 显式类型转换
+    canardRxSubscribe(&canard,CanardTransferKindRequest,SERVICE_ID_ENABLE,
+                     dinosaurs_actuator_wheel_motor_Enable_Request_1_0_EXTENT_BYTES_,
+                     CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                     &sub_enable);
+#endif
+#if defined(CONFIG_CANARD_SERVICE_SET_TARGET)
+    static CanardRxSubscription sub_setTar;
+
+    sub_setTar.user_reference = handle_set_targe;
+    canardRxSubscribe(&canard, CanardTransferKindRequest, SERVICE_ID_SET_TARGET, SET_TARGET_REQUEST_EXTENT, CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC, &sub_setTar);
+#endif
+
+#if defined(CONFIG_CANARD_SERVICE_PID_PARAMETER)
+    static CanardRxSubscription sub_pid_param;
+    canardRxSubscribe(&canard,
+                     CanardTransferKindRequest,
+                     dinosaurs_PortId_1_0_dinosaurs_actuator_wheel_motor_PidParameter_1_0_FIXED_PORT_ID_,
+                     dinosaurs_actuator_wheel_motor_PidParameter_Request_1_0_EXTENT_BYTES_,
+                     CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                     &sub_pid_param);
+    sub_pid_param.user_reference = (void*)handle_pid_parameter;
+#endif
+
+#if defined(CONFIG_CANARD_SERVICE_SET_MODE)
+    static CanardRxSubscription sub_mode;
+    canardRxSubscribe(&canard,
+                     CanardTransferKindRequest,
+                     dinosaurs_PortId_1_0_actuator_wheel_motor_SetMode_2_0_ID,
+                     dinosaurs_actuator_wheel_motor_SetMode_Request_2_0_EXTENT_BYTES_,
+                     CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                     &sub_mode);
+    sub_mode.user_reference = (void*)handle_set_mode;
+#endif
+
+#if defined(CONFIG_CANARD_SERVICE_OPERATE_REMOTE_DEVICE)
+    static CanardRxSubscription sub_remote_device;
+    canardRxSubscribe(&canard,
+                     CanardTransferKindRequest,
+                     SERVICE_ID_OPERATE_REMOTE_DEVICE,
+                     dinosaurs_peripheral_OperateRemoteDevice_Request_1_0_EXTENT_BYTES_,
+                     CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                     &sub_remote_device);
+    sub_remote_device.user_reference = (void*)handle_operate_remote_device;
+#endif
+
+    static CanardRxSubscription sub_time_sync;
+    canardRxSubscribe(&canard,
+                     CanardTransferKindMessage,
+                     CANARD_TIME_SYNC_PORT_ID,
+                     CANARD_TIME_SYNC_EXTENT,
+                     CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                     &sub_time_sync);
+    sub_time_sync.user_reference = (void*)handle_time_sync;
+
+#if defined(CONFIG_ELEVATOR_GROUP)
+    static CanardRxSubscription sub_group;
+    canardRxSubscribe(&canard,
+                     CanardTransferKindMessage,
+                     CONFIG_ELEVATOR_GROUP_PORT_ID,
+                     ELEVATOR_GROUP_STATUS_SIZE,
+                     CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                     &sub_group);
+    sub_group.user_reference = (void*)handle_group_status;
+#endif
+
+#if defined(CONFIG_CANARD_SCOPE)
+    static CanardRxSubscription sub_scope;
+    canardRxSubscribe(&canard,
+                     CanardTransferKindRequest,
+                     CONFIG_CANARD_SCOPE_SERVICE_ID,
+                     CANARD_SCOPE_REQUEST_EXTENT,
+                     CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                     &sub_scope);
+    sub_scope.user_reference = (void*)handle_scope;
+#endif
+
+#if defined(CONFIG_CANARD_BLACKBOX)
+    static CanardRxSubscription sub_blackbox;
+    canardRxSubscribe(&canard,
+                     CanardTransferKindRequest,
+                     CONFIG_CANARD_BLACKBOX_SERVICE_ID,
+                     CANARD_BLACKBOX_REQUEST_EXTENT,
+                     CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                     &sub_blackbox);
+    sub_blackbox.user_reference = (void*)handle_blackbox;
+#endif
+
+#if defined(CONFIG_PID_AUTOTUNE)
+    static CanardRxSubscription sub_autotune;
+    canardRxSubscribe(&canard,
+                     CanardTransferKindRequest,
+                     CONFIG_PID_AUTOTUNE_SERVICE_ID,
+                     PID_AUTOTUNE_REQUEST_EXTENT,
+                     CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                     &sub_autotune);
+    sub_autotune.user_reference = (void*)handle_autotune;
+#endif
+
+#if defined(CONFIG_CANARD_REGISTER)
+    static CanardRxSubscription sub_register_access;
+    canardRxSubscribe(&canard,
+                     CanardTransferKindRequest,
+                     uavcan_register_Access_1_0_FIXED_PORT_ID_,
+                     uavcan_register_Access_Request_1_0_EXTENT_BYTES_,
+                     CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                     &sub_register_access);
+    sub_register_access.user_reference = (void*)handle_register_access;
+
+    static CanardRxSubscription sub_register_list;
+    canardRxSubscribe(&canard,
+                     CanardTransferKindRequest,
+                     uavcan_register_List_1_0_FIXED_PORT_ID_,
+                     uavcan_register_List_Request_1_0_EXTENT_BYTES_,
+                     CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                     &sub_register_list);
+    sub_register_list.user_reference = (void*)handle_register_list;
+#endif
+}
+#include <lib/bldcmotor/motor.h>
+
+#if defined(CONFIG_CANARD_SERVICE_OPERATE_REMOTE_DEVICE)
+/* DSDL 中只定义了 SUCESS(0), 非零即表示失败 */
+#define OPERATE_RESULT_FAILED 1U
+
+static bool operate_remote_device_respond(const CanardTransferMetadata* req_meta,
+                                          uint8_t result, const char* text)
+{
+    dinosaurs_peripheral_OperateRemoteDevice_Response_1_0 resp = {
+        .result = result
+    };
+    int len = snprintf((char*)resp.value.elements, sizeof(resp.value.elements), "%s", text);
+    resp.value.count = MIN((size_t)MAX(len, 0), sizeof(resp.value.elements) - 1);
+
+    uint8_t buffer[64];
+    size_t buffer_size = sizeof(buffer);
+    dinosaurs_peripheral_OperateRemoteDevice_Response_1_0_serialize_(
+        &resp, buffer, &buffer_size);
+
+    const CanardTransferMetadata meta = {
+        .priority = CanardPriorityNominal,
+        .transfer_kind = CanardTransferKindResponse,
+        .port_id = req_meta->port_id,
+        .remote_node_id = req_meta->remote_node_id,
+        .transfer_id = req_meta->transfer_id
+    };
+    return canard_if_push(&meta, buffer_size, buffer) > 0;
+}
+
+#if defined(CONFIG_CANARD_ELEVATOR)
+/*
+ * 顶升命令的延迟响应: 请求进入命令队列后先记下请求的元数据,
+ * 电机线程真正到达 OPEN/CLOSE 后再回复, 主机据此流水线下发命令.
+ * 超时从电机线程取走命令时开始计, 到期先取消命令使电机停下,
+ * 等电机线程回报 ABORTED 后才回复失败, 主机重试不会叠加行程.
+ * 完成记录先存进槽位, 响应入队失败时保留到下一轮重试.
+ */
+struct elevator_pending {
+    bool used;
+    bool cancelling;
+    bool completed;      //done 有效, 等待回复
+    uint8_t req_id;
+    int64_t deadline;    //0 表示仍在队列中排队
+    CanardTransferMetadata meta;
+    struct elevator_done done;
+};
+static struct elevator_pending elevator_pending[CONFIG_ELEVATOR_CMD_QUEUE_DEPTH];
+static uint8_t elevator_req_seq;
+
+static int elevator_submit(const CanardTransferMetadata* meta, uint8_t type, float height)
+{
+    struct elevator_pending* slot = NULL;
+    for (size_t i = 0; i < ARRAY_SIZE(elevator_pending); i++) {
+        if (!elevator_pending[i].used) {
+            slot = &elevator_pending[i];
+            break;
+        }
+    }
+    if (slot == NULL) {
+        return -ENOBUFS;
+    }
+
+    const struct elevator_cmd cmd = {
+        .type = type,
+        .req_id = elevator_req_seq++,
+        .height = height,
+    };
+    int ret = elevator_cmd_post(&cmd);
+    if (ret < 0) {
+        return ret;
+    }
+    slot->used = true;
+    slot->cancelling = false;
+    slot->completed = false;
+    slot->req_id = cmd.req_id;
+    slot->deadline = 0;
+    slot->meta = *meta;
+    return 0;
+}
+
+// 回复已完成的顶升命令并取消超时的命令, 在 canard_thread 中周期调用
+static void elevator_poll_completions(void)
+{
+    struct elevator_done done;
+    char text[48];
+
+    while (elevator_done_get(&done) == 0) {
+        for (size_t i = 0; i < ARRAY_SIZE(elevator_pending); i++) {
+            struct elevator_pending* p = &elevator_pending[i];
+            if (p->used && !p->completed && p->req_id == done.req_id) {
+                p->done = done;
+                p->completed = true;
+                break;
+            }
+        }
+    }
+
+    const int64_t now = k_uptime_get();
+    for (size_t i = 0; i < ARRAY_SIZE(elevator_pending); i++) {
+        struct elevator_pending* p = &elevator_pending[i];
+        if (p->used && p->completed) {
+            snprintf(text, sizeof(text), "ieb_motor_lift %sstate %d height %d",
+                     p->done.result == ELEVATOR_RESULT_ABORTED ? "timeout " :
+                     p->done.result == ELEVATOR_RESULT_FAIL ? "stalled " : "",
+                     p->done.state, (int)p->done.height);
+            // 发送队列满或堆耗尽时保留, 下一轮重试
+            if (operate_remote_device_respond(&p->meta,
+                    p->done.result == ELEVATOR_RESULT_OK ?
+                        dinosaurs_peripheral_OperateRemoteDevice_Response_1_0_SUCESS :
+                        OPERATE_RESULT_FAILED,
+                    text)) {
+                p->used = false;
+            }
+            continue;
+        }
+        if (!p->used || p->cancelling) {
+            continue;
+        }
+        if (p->deadline == 0) {
+            if (elevator_cmd_running(p->req_id)) {
+                p->deadline = now + CONFIG_ELEVATOR_CMD_TIMEOUT_MS;
+            }
+        } else if (now >= p->deadline) {
+            // 完成记录随后到达; 若恰好已完成, 取消请求被忽略, 按实际结果回复
+            elevator_cmd_cancel(p->req_id);
+            p->cancelling = true;
+        }
+    }
+}
+#else
+extern uint8_t conctrl_cmd;
+#endif /* CONFIG_CANARD_ELEVATOR */
+
+ // 远程设备操作处理函数
+ static void handle_operate_remote_device(CanardRxTransfer* transfer)
+ {
+     dinosaurs_peripheral_OperateRemoteDevice_Request_1_0 req = {0};
+     size_t inout_size = transfer->payload_size;
+     if (dinosaurs_peripheral_OperateRemoteDevice_Request_1_0_deserialize_(
+         &req, transfer->payload, &inout_size) >= 0) 
+     {
+         // 转换设备名和参数为字符串
+         char device_name[32] = {0};
+         char device_param[32] = {0};
+         memcpy(device_name, req.name.elements, MIN(req.name.count, sizeof(device_name) - 1));
+         memcpy(device_param, req.param.elements, MIN(req.param.count, sizeof(device_param) - 1));
+         
+         LOG_RL_INF("Remote device operation: method=%u, name='%s', param='%s'", 
+                req.method, device_name, device_param);
+        if(!strcmp(device_name,"ieb_motor_lift"))
+        {
+#if defined(CONFIG_CANARD_ELEVATOR)
+            uint8_t type = ELEVATOR_CMD_NONE;
+            float height = 0.0f;
+            if(req.method == dinosaurs_peripheral_OperateRemoteDevice_Request_1_0_OPEN)
+            {
+                type = ELEVATOR_CMD_OPEN;
+                // param 携带目标高度时为定位命令, 空则为全行程顶升
+                if (device_param[0] != '\0') {
+                    char* end;
+                    height = strtof(device_param, &end);
+                    if (end == device_param || *end != '\0' ||
+                        !(height >= 0.0f && height <= ELEVATOR_HEIGHT_MAX)) {
+                        operate_remote_device_respond(&transfer->metadata, OPERATE_RESULT_FAILED,
+                                                      "ieb_motor_lift bad height");
+                        return;
+                    }
+                    type = ELEVATOR_CMD_MOVE_TO;
+                }
+            }else if(req.method == dinosaurs_peripheral_OperateRemoteDevice_Request_1_0_CLOSE){
+                type = ELEVATOR_CMD_CLOSE;
+            }else{
+    
+            }
+            if (type != ELEVATOR_CMD_NONE) {
+                // 成功入队则等到动作完成后再回复
+                if (elevator_submit(&transfer->metadata, type, height) < 0) {
+                    operate_remote_device_respond(&transfer->metadata, OPERATE_RESULT_FAILED,
+                                                  "ieb_motor_lift busy");
+                    return;
+                }
+#if defined(CONFIG_CANARD_SCOPE)
+                canard_scope_command_event();
+#endif
+                return;
+            }
+#else
+            if(req.method == dinosaurs_peripheral_OperateRemoteDevice_Request_1_0_OPEN)
+            {
+                conctrl_cmd = 1; 
+            }else if(req.method == dinosaurs_peripheral_OperateRemoteDevice_Request_1_0_CLOSE){
+                conctrl_cmd = 2;
+            }
+#endif
+        }else if(!strcmp(device_name,"m-brake")){
+
+        }else{}                
+         
+         char text[64];
+         snprintf(text, sizeof(text), "Operation %s executed", device_name);
+         operate_remote_device_respond(&transfer->metadata,
+             dinosaurs_peripheral_OperateRemoteDevice_Response_1_0_SUCESS, text);
+     }
+ }
+#endif /* CONFIG_CANARD_SERVICE_OPERATE_REMOTE_DEVICE */
+static void handle_time_sync(CanardRxTransfer* transfer)
+{
+    canard_time_on_sync(transfer);
+}
+#if defined(CONFIG_CANARD_SERVICE_SET_MODE)
+static void handle_set_mode(CanardRxTransfer* transfer) {
+    dinosaurs_actuator_wheel_motor_SetMode_Request_2_0 req = {0};
+    size_t inout_size = transfer->payload_size;
+    
+    if (dinosaurs_actuator_wheel_motor_SetMode_Request_2_0_deserialize_(
+        &req, transfer->payload, &inout_size) >= 0) 
+    {
+        // 模式转换逻辑
+        switch(req.mode) {
+            case dinosaurs_actuator_wheel_motor_SetMode_Request_2_0_SPEED_MODE:
+                // motor_cmd_set(MOTOR_CMD_SET_SPEED_MODE, NULL, 0);
+                break;
+            case dinosaurs_actuator_wheel_motor_SetMode_Request_2_0_CURRENT_MODE:
+                // motor_cmd_set(MOTOR_CMD_SET_TORQUE_MODE, NULL, 0);
+                break;
+            // 其他模式处理...
+            case dinosaurs_actuator_wheel_motor_SetMode_Request_2_0_POSITION_MODE:
+                // motor_cmd_set(MOTOR_CMD_SET_POSTION_MODE, NULL, 0);
+                break;
+        }
+
+        // 准备响应
+        dinosaurs_actuator_wheel_motor_SetMode_Response_2_0 resp = {
+            .status = dinosaurs_actuator_wheel_motor_SetMode_Response_2_0_SET_SUCCESS
+        };
+        
+        uint8_t buffer[dinosaurs_actuator_wheel_motor_SetMode_Response_2_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+        size_t buffer_size = sizeof(buffer);
+        dinosaurs_actuator_wheel_motor_SetMode_Response_2_0_serialize_(
+            &resp, buffer, &buffer_size);
+        
+        const CanardTransferMetadata meta = {
+            .priority = CanardPriorityNominal,
+            .transfer_kind = CanardTransferKindResponse,
+            .port_id = transfer->metadata.port_id,
+            .remote_node_id = transfer->metadata.remote_node_id,
+            .transfer_id = transfer->metadata.transfer_id
+        };
+        canard_if_push(&meta, buffer_size, buffer);
+    }
+}
+#endif
+#if defined(CONFIG_CANARD_SERVICE_ENABLE)
+// 电机使能处理函数
+static void handle_motor_enable(CanardRxTransfer* transfer)
+{
+    dinosaurs_actuator_wheel_motor_Enable_Request_1_0 req = {0};
+    size_t inout_size = transfer->payload_size;
+    
+    if (dinosaurs_actuator_wheel_motor_Enable_Request_1_0_deserialize_(&req, 
+            transfer->payload, &inout_size) >= 0) {
+        
+        LOG_RL_INF("Motor enable cmd from node %d: %d", 
+               transfer->metadata.remote_node_id, req.enable_state);
+        
+        // 执行电机控制
+        if(req.enable_state == 0) {
+            // motor_cmd_set(MOTOR_CMD_SET_ENABLE,0,0);
+        } else {
+            // motor_cmd_set(MOTOR_CMD_SET_DISABLE,0,0);
+        }
+        // 发送响应
+        dinosaurs_actuator_wheel_motor_Enable_Response_1_0 resp = {
+            .status = dinosaurs_actuator_wheel_motor_Enable_Response_1_0_SET_SUCCESS
+        };
+        
+        uint8_t buffer[dinosaurs_actuator_wheel_motor_Enable_Response_1_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+        size_t buffer_size = sizeof(buffer);
+        dinosaurs_actuator_wheel_motor_Enable_Response_1_0_serialize_(&resp, buffer, &buffer_size);
+        
+        const CanardTransferMetadata meta = {
+            .priority = CanardPriorityNominal,
+            .transfer_kind = CanardTransferKindResponse,
+            .port_id = transfer->metadata.port_id,
+            .remote_node_id = transfer->metadata.remote_node_id,
+            .transfer_id = transfer->metadata.transfer_id
+        };
+        canard_if_push(&meta, buffer_size, buffer);
+    }
+}
+#endif
+#if defined(CONFIG_CANARD_SERVICE_SET_TARGET)
+/*
+ * 带生效时间的设定值: canard_thread 入队, 电机线程到时后生效.
+ * SetTargetValue 请求可在标准字段之后追加 7 字节 uint56 生效时间(总线时间, 微秒),
+ * 仍在订阅的 extent 之内; 未携带、未同步或超出提前量时立即生效.
+ */
+#define SETPOINT_APPLY_AT_SIZE   7U
+#define SETPOINT_MAX_LEAD_USEC   1000000U
+
+struct setpoint_item {
+    float target;
+    uint64_t apply_at;   // 本地时间, 0 表示立即生效
+};
+SPSC_DEFINE(setpoint_q, struct setpoint_item, CONFIG_CANARD_SETPOINT_QUEUE_DEPTH);
+
+bool canard_if_setpoint_due(float* target)
+{
+    const uint64_t now = canard_time_local_usec();
+    struct setpoint_item* it;
+    bool due = false;
+
+    // 取出所有已到时的设定值, 以最新的为准
+    while ((it = spsc_peek(&setpoint_q)) != NULL && it->apply_at <= now) {
+        *target = it->target;
+        due = true;
+        (void)spsc_consume(&setpoint_q);
+        spsc_release(&setpoint_q);
+    }
+    return due;
+}
+
+static uint64_t setpoint_apply_at(const uint8_t* data, size_t len, size_t consumed)
+{
+    if (len < consumed + SETPOINT_APPLY_AT_SIZE || !canard_time_synced()) {
+        return 0;
+    }
+    const uint8_t* p = data + consumed;
+    const uint64_t sync_at = (uint64_t)sys_get_le32(p) | ((uint64_t)sys_get_le24(p + 4) << 32);
+    if (sync_at == 0) {
+        return 0;
+    }
+    const uint64_t local = canard_time_to_local(sync_at);
+    if (local > canard_time_local_usec() + SETPOINT_MAX_LEAD_USEC) {
+        return 0;
+    }
+    return local;
+}
+
+static void handle_set_targe(CanardRxTransfer* transfer)
+{
+    const uint8_t* data; size_t len; CanardNodeID sender_id;CanardPortID port_id;
+    data = transfer->payload;
+    sender_id = transfer->metadata.remote_node_id;
+    len = transfer->payload_size;
+    port_id = transfer->metadata.port_id;
+    dinosaurs_actuator_wheel_motor_SetTargetValue_Request_2_0 req;
+    size_t inout_size = len;
+#if defined(CONFIG_CANARD_FAST_DECODE)
+    if (canard_fast_set_target_decode(&req, data, &inout_size) >= 0) {
+#else
+    if (dinosaurs_actuator_wheel_motor_SetTargetValue_Request_2_0_deserialize_(&req, data, &inout_size) >= 0) {
+#endif
+        // LOG_INF("Node %u set targe: %f  %f", sender_id, (double)req.velocity.elements[0].meter_per_second,
+        // (double)req.velocity.elements[1].meter_per_second);
+
+        /*
+            
+        */
+        // motor_set_ref_param(0,req.velocity.elements[0].meter_per_second,0.0f);
+
+        float buf[2];
+        buf[0] = req.velocity.elements[0].meter_per_second;
+        buf[1] = req.velocity.elements[1].meter_per_second;
+        struct setpoint_item* slot = spsc_acquire(&setpoint_q);
+        if (slot != NULL) {
+            slot->target = buf[0];
+            slot->apply_at = setpoint_apply_at(data, len, inout_size);
+            spsc_produce(&setpoint_q);
+        } else {
+            LOG_RL_WRN("Setpoint queue full");
+        }
+        // motor_cmd_set(MOTOR_CMD_SET_SPEED,buf,ARRAY_SIZE(buf));
+        // 创建响应
+        dinosaurs_actuator_wheel_motor_SetTargetValue_Response_2_0 response = {
+            .status = dinosaurs_actuator_wheel_motor_SetTargetValue_Response_2_0_SET_SUCCESS
+        };
+    
+        uint8_t buffer[dinosaurs_actuator_wheel_motor_SetTargetValue_Response_2_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+        size_t buffer_size = sizeof(buffer);
+        uint8_t result = dinosaurs_actuator_wheel_motor_SetTargetValue_Response_2_0_serialize_(&response, buffer, &buffer_size);  // 使用Response类型的序列化函数        
+        if (result < 0) {
+            LOG_INF("Error serializing response\n");
+            return;
+        }
+        const CanardTransferMetadata meta = {
+            .priority = CanardPriorityNominal,
+            .transfer_kind = CanardTransferKindResponse,
+            .port_id = transfer->metadata.port_id,
+            .remote_node_id = transfer->metadata.remote_node_id,
+            .transfer_id = transfer->metadata.transfer_id
+        };
+        canard_if_push(&meta, buffer_size, buffer);    
+    }
+}
+#endif
+/*
+ * PID 参数双缓冲: canard_thread 校验后写入影子参数组, 电机线程在控制周期
+ * 边界通过 canard_if_pid_due() 切换. 影子组只在 pid_staged 为 0 时由
+ * canard_thread 写, 为 1 时由电机线程读, 两个线程不会同时访问同一组.
+ * 参数顺序: [speed_kp, speed_ki, posi_kp, posi_ki], NaN 表示该项不修改
+ *
+ * 没有 CONFIG_APP_PID_APPLY 时驱动无法加载增益: 服务保持原来的行为,
+ * 应答成功但不生效, 也不提供寄存器 dinosaurs.pid.gains.
+ */
+#define PID_PARAM_COUNT 4U
+/* DSDL 中只定义了 SET_SUCCESS(0), 非零即表示失败 */
+#define PID_PARAM_STATUS_FAILED 1U
+
+/* 单项增益上限, 与寄存器 dinosaurs.pid.gains 的范围一致 */
+#define PID_GAIN_MAX 1.0e6f
+
+/*
+ * 当前生效的增益, 同时是寄存器 dinosaurs.pid.gains 的存储. 寄存器写入与
+ * PidParameter 服务都更新这里, 回读与持久化因此总是最后生效的一组.
+ * NaN: 沿用驱动默认值
+ */
+#if defined(CONFIG_APP_PID_APPLY)
+#if defined(CONFIG_CANARD_REGISTER) || defined(CONFIG_CANARD_SERVICE_PID_PARAMETER)
+static float pid_gains[PID_PARAM_COUNT] = { NAN, NAN, NAN, NAN };
+#endif
+
+static float pid_sets[2][PID_PARAM_COUNT];
+static atomic_t pid_shadow;     // 影子参数组下标
+static atomic_t pid_staged;     // 1: 影子参数组等待电机线程切换
+
+static int pid_params_stage(const float* params)
+{
+    for (size_t i = 0; i < PID_PARAM_COUNT; i++) {
+        if (isnan(params[i])) {
+            continue;   // NaN: 保持该项当前值
+        }
+        if (!isfinite(params[i]) || params[i] < 0.0f || params[i] > PID_GAIN_MAX) {
+            return -EINVAL;
+        }
+    }
+    // 上一组尚未被电机线程取走
+    if (atomic_get(&pid_staged) != 0) {
+        return -EBUSY;
+    }
+    memcpy(pid_sets[atomic_get(&pid_shadow)], params, sizeof(pid_sets[0]));
+    atomic_set(&pid_staged, 1);
+    return 0;
+}
+
+bool canard_if_pid_due(const float** params)
+{
+    if (atomic_get(&pid_staged) == 0) {
+        return false;
+    }
+    const atomic_val_t idx = atomic_get(&pid_shadow);
+
+    *params = pid_sets[idx];
+    atomic_set(&pid_shadow, idx ^ 1);
+    atomic_clear(&pid_staged);
+    return true;
+}
+#endif /* CONFIG_APP_PID_APPLY */
+
+#if defined(CONFIG_CANARD_SERVICE_PID_PARAMETER)
+#if defined(CONFIG_APP_PID_APPLY)
+/* 服务写入的增益并入 pid_gains, NaN 项保持原值 */
+static void pid_gains_merge(const float* params)
+{
+    float merged[PID_PARAM_COUNT];
+
+    for (size_t i = 0; i < PID_PARAM_COUNT; i++) {
+        merged[i] = isnan(params[i]) ? pid_gains[i] : params[i];
+    }
+#if defined(CONFIG_CANARD_REGISTER)
+    (void)canard_register_update(pid_gains, merged);
+#else
+    memcpy(pid_gains, merged, sizeof(pid_gains));
+#endif
+}
+#endif /* CONFIG_APP_PID_APPLY */
+
+static void handle_pid_parameter(CanardRxTransfer* transfer)
+{
+    dinosaurs_actuator_wheel_motor_PidParameter_Request_1_0 req = {0};
+    size_t inout_size = transfer->payload_size;
+    
+    if (dinosaurs_actuator_wheel_motor_PidParameter_Request_1_0_deserialize_(
+        &req, transfer->payload, &inout_size) >= 0) 
+    {
+#if defined(CONFIG_APP_PID_APPLY)
+        // 校验通过后暂存, 由电机线程在下一个控制周期边界生效
+        const int ret = pid_params_stage(req.pid_params);
+        if (ret < 0) {
+            LOG_WRN("PID params from node %u rejected: %d",
+                    transfer->metadata.remote_node_id, ret);
+        } else {
+            pid_gains_merge(req.pid_params);
+        }
+#else
+        const int ret = 0;   // 驱动不能加载增益, 与原来一样只应答
+#endif
+
+        // 准备响应
+        dinosaurs_actuator_wheel_motor_PidParameter_Response_1_0 resp = {
+            .status = (ret == 0) ? dinosaurs_actuator_wheel_motor_PidParameter_Response_1_0_SET_SUCCESS
+                                 : PID_PARAM_STATUS_FAILED
+        };
+        
+        uint8_t buffer[dinosaurs_actuator_wheel_motor_PidParameter_Response_1_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+        size_t buffer_size = sizeof(buffer);
+        dinosaurs_actuator_wheel_motor_PidParameter_Response_1_0_serialize_(
+            &resp, buffer, &buffer_size);
+        
+        const CanardTransferMetadata meta = {
+            .priority = CanardPriorityNominal,
+            .transfer_kind = CanardTransferKindResponse,
+            .port_id = transfer->metadata.port_id,
+            .remote_node_id = transfer->metadata.remote_node_id,
+            .transfer_id = transfer->metadata.transfer_id
+        };
+        canard_if_push(&meta, buffer_size, buffer);
+    }
+}
+#endif
+
+#if defined(CONFIG_CANARD_SCOPE)
+// 示波器服务: 请求/响应格式见 canard_scope.h, 响应直接用原始字节
+static void handle_scope(CanardRxTransfer* transfer)
+{
+    uint8_t buffer[CONFIG_CANARD_SCOPE_CHUNK_BYTES];
+    const size_t len = canard_scope_handle(transfer->payload, transfer->payload_size,
+                                           buffer, sizeof(buffer));
+    if (len == 0U) {
+        return;
+    }
+    const CanardTransferMetadata meta = {
+        .priority = CanardPriorityLow,
+        .transfer_kind = CanardTransferKindResponse,
+        .port_id = transfer->metadata.port_id,
+        .remote_node_id = transfer->metadata.remote_node_id,
+        .transfer_id = transfer->metadata.transfer_id
+    };
+    canard_if_push(&meta, len, buffer);
+}
+#endif
+
+#if defined(CONFIG_CANARD_BLACKBOX)
+// 黑匣子读取服务: 请求/响应格式见 canard_blackbox.h
+static void handle_blackbox(CanardRxTransfer* transfer)
+{
+    uint8_t buffer[CANARD_BLACKBOX_RESPONSE_MAX];
+    const size_t len = canard_blackbox_handle(transfer->payload, transfer->payload_size,
+                                              buffer, sizeof(buffer));
+    if (len == 0U) {
+        return;
+    }
+    const CanardTransferMetadata meta = {
+        .priority = CanardPriorityLow,
+        .transfer_kind = CanardTransferKindResponse,
+        .port_id = transfer->metadata.port_id,
+        .remote_node_id = transfer->metadata.remote_node_id,
+        .transfer_id = transfer->metadata.transfer_id
+    };
+    canard_if_push(&meta, len, buffer);
+}
+#endif
+
+#if defined(CONFIG_PID_AUTOTUNE)
+/* 自整定 START 的延迟响应: 实验结束后由 autotune_poll_completion() 回复 */
+static bool autotune_pending;
+static CanardTransferMetadata autotune_meta;
+
+static bool autotune_respond(const CanardTransferMetadata* req_meta, int err)
+{
+    uint8_t buffer[PID_AUTOTUNE_RESULT_SIZE];
+    const size_t len = pid_autotune_result(buffer, err);
+    const CanardTransferMetadata meta = {
+        .priority = CanardPriorityNominal,
+        .transfer_kind = CanardTransferKindResponse,
+        .port_id = req_meta->port_id,
+        .remote_node_id = req_meta->remote_node_id,
+        .transfer_id = req_meta->transfer_id
+    };
+    return canard_if_push(&meta, len, buffer) > 0;
+}
+
+// 自整定服务: 请求/响应格式见 pid_autotune.h
+static void handle_autotune(CanardRxTransfer* transfer)
+{
+    const uint8_t* req = transfer->payload;
+    int err = 0;
+
+    if (transfer->payload_size < 1U) {
+        return;
+    }
+    switch (req[0]) {
+    case PID_AUTOTUNE_OP_START:
+        err = pid_autotune_start(req, transfer->payload_size);
+        if (err == 0) {
+            autotune_meta = transfer->metadata;
+            autotune_pending = true;
+            return;
+        }
+        break;
+    case PID_AUTOTUNE_OP_ABORT:
+        pid_autotune_abort();
+        break;
+    case PID_AUTOTUNE_OP_STATUS:
+        break;
+    default:
+        err = -ENOTSUP;
+        break;
+    }
+    (void)autotune_respond(&transfer->metadata, err);
+}
+
+static void autotune_poll_completion(void)
+{
+    // 被发送预算拒绝时保留, 下一轮重试
+    if (autotune_pending && pid_autotune_finished() &&
+        autotune_respond(&autotune_meta, 0)) {
+        autotune_pending = false;
+    }
+}
+#endif
+
+#if defined(CONFIG_CANARD_REGISTER)
+/*
+ * 可配置参数. 节点号, 波特率与顶升行程只在启动时读取, 写入后重启生效;
+ * PID 增益与发布周期写入即生效. 表项指向各模块直接读取的普通变量.
+ */
+#define REG_RW (CANARD_REGISTER_MUTABLE | CANARD_REGISTER_PERSISTENT)
+
+#if defined(CONFIG_CANARD_FD)
+static uint32_t can_bitrate_reg[2] = { CAN_BITRATE, CAN_DATA_BITRATE };
+#else
+static uint32_t can_bitrate_reg[2] = { CAN_BITRATE, CAN_BITRATE };   // 经典 CAN 两段相同
+#endif
+#if defined(CONFIG_CANARD_ELEVATOR)
+static float rising_dis_reg = ELEVATOR_HEIGHT_MAX;
+#endif
+
+static int apply_can_bitrate(const struct canard_register* reg)
+{
+    ARG_UNUSED(reg);
+    can_bitrate = can_bitrate_reg[0];
+#if defined(CONFIG_CANARD_FD)
+    can_data_bitrate = can_bitrate_reg[1];
+#endif
+    return 0;
+}
+
+#if defined(CONFIG_CANARD_ELEVATOR)
+static int apply_rising_dis(const struct canard_register* reg)
+{
+    ARG_UNUSED(reg);
+    elevator_rising_dis = rising_dis_reg;
+    return 0;
+}
+#endif
+
+#if defined(CONFIG_APP_PID_APPLY)
+static int apply_pid_gains(const struct canard_register* reg)
+{
+    ARG_UNUSED(reg);
+    return pid_params_stage(pid_gains);
+}
+#endif
+
+#if defined(CONFIG_CANARD_MOVABLE_ADDONS)
+static int apply_movable_addons_period(const struct canard_register* reg)
+{
+    ARG_UNUSED(reg);
+    canard_sched_set_period(&movable_addons_pub, movable_addons_period_ms);
+    return 0;
+}
+#endif
+
+static const struct canard_register registers[] = {
+    CANARD_REGISTER_ENTRY("uavcan.node.id", node_id, CANARD_REGISTER_NATURAL16,
+                          REG_RW | CANARD_REGISTER_RESTART, 0.0f, 127.0f, NULL),
+    CANARD_REGISTER_ENTRY("uavcan.can.bitrate", can_bitrate_reg, CANARD_REGISTER_NATURAL32,
+                          REG_RW | CANARD_REGISTER_RESTART, 125000.0f, 8000000.0f, apply_can_bitrate),
+#if defined(CONFIG_APP_PID_APPLY)
+    CANARD_REGISTER_ENTRY("dinosaurs.pid.gains", pid_gains, CANARD_REGISTER_REAL32,
+                          REG_RW | CANARD_REGISTER_NAN, 0.0f, PID_GAIN_MAX, apply_pid_gains),
+#endif
+#if defined(CONFIG_CANARD_MOVABLE_ADDONS)
+    CANARD_REGISTER_ENTRY("dinosaurs.movable_addons.period_ms", movable_addons_period_ms,
+                          CANARD_REGISTER_NATURAL16, REG_RW, 10.0f, 60000.0f, apply_movable_addons_period),
+#endif
+    CANARD_REGISTER_ENTRY("dinosaurs.boot.milestones_ms", boot_ms, CANARD_REGISTER_NATURAL32,
+                          0, 0.0f, (float)UINT32_MAX, NULL),
+#if defined(CONFIG_CANARD_ELEVATOR)
+    CANARD_REGISTER_ENTRY("dinosaurs.elevator.rising_dis", rising_dis_reg, CANARD_REGISTER_REAL32,
+                          REG_RW | CANARD_REGISTER_RESTART, 1.0f, ELEVATOR_HEIGHT_MAX, apply_rising_dis),
+#endif
+};
+
+static void registers_init(void)
+{
+    const int ret = canard_register_init(registers, ARRAY_SIZE(registers));
+    if (ret < 0) {
+        LOG_ERR("Register table rejected: %d", ret);
+    }
+}
+
+// uavcan.register.Access, 请求与响应由 canard_register 编解码
+static void handle_register_access(CanardRxTransfer* transfer)
+{
+    uint8_t buffer[uavcan_register_Access_Response_1_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+    const size_t len = canard_register_access(transfer->payload, transfer->payload_size,
+                                              buffer, sizeof(buffer));
+    if (len == 0U) {
+        return;
+    }
+    const CanardTransferMetadata meta = {
+        .priority = CanardPriorityLow,
+        .transfer_kind = CanardTransferKindResponse,
+        .port_id = transfer->metadata.port_id,
+        .remote_node_id = transfer->metadata.remote_node_id,
+        .transfer_id = transfer->metadata.transfer_id
+    };
+    canard_if_push(&meta, len, buffer);
+}
+
+// uavcan.register.List
+static void handle_register_list(CanardRxTransfer* transfer)
+{
+    uint8_t buffer[uavcan_register_List_Response_1_0_SERIALIZATION_BUFFER_SIZE_BYTES_];
+    const size_t len = canard_register_list(transfer->payload, transfer->payload_size,
+                                            buffer, sizeof(buffer));
+    if (len == 0U) {
+        return;
+    }
+    const CanardTransferMetadata meta = {
+        .priority = CanardPriorityLow,
+        .transfer_kind = CanardTransferKindResponse,
+        .port_id = transfer->metadata.port_id,
+        .remote_node_id = transfer->metadata.remote_node_id,
+        .transfer_id = transfer->metadata.transfer_id
+    };
+    canard_if_push(&meta, len, buffer);
+}
+#endif
@@ -0,0 +1,153 @@
+/**
+ * @file canard_load.c
+ * @brief Bus load meter and per-priority TX budgets
+ *
+ * Frame lengths are converted to worst-case bit counts (stuffing
+ * included) by the driver, so the measured load is an upper bound.
+ * All functions run in the canard thread; only the driver counters are
+ * shared with the ISR and read through atomic_clear().
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#include "canard_load.h"
+#include "../stm32_can.h"
+
+LOG_MODULE_REGISTER(canard_load, LOG_LEVEL_INF);
+
+#define LOAD_WINDOW_MS    100
+#define LOAD_WINDOW_BITS  ((uint64_t)can_bitrate * LOAD_WINDOW_MS / 1000U)
+#define LOAD_EMA_DIV      4       //负载滑动平均 1/4, 避免预算来回跳变
+
+/* 预算分组: 高于 Nominal 的优先级只计数不限制 */
+enum load_class {
+    LOAD_CLASS_HIGH = 0,
+    LOAD_CLASS_NOMINAL,
+    LOAD_CLASS_LOW,      //Low, Slow, Optional 共用
+    LOAD_CLASS_COUNT
+};
+
+static const uint8_t class_budget_pct[LOAD_CLASS_COUNT] = {
+    [LOAD_CLASS_HIGH] = 100,
+    [LOAD_CLASS_NOMINAL] = CONFIG_CANARD_TX_BUDGET_NOMINAL_PCT,
+    [LOAD_CLASS_LOW] = CONFIG_CANARD_TX_BUDGET_LOW_PCT,
+};
+
+static struct {
+    uint32_t used[LOAD_CLASS_COUNT];     //本窗口已用比特
+    uint32_t budget[LOAD_CLASS_COUNT];   //本窗口预算
+    uint32_t tx_bits;                    //本窗口自身发送比特
+    int64_t window_start;
+    uint32_t load_ema;                   //千分比
+    bool started;
+} gov;
+
+static struct canard_load_stats stats;
+
+static enum load_class load_class_of(CanardPriority priority)
+{
+    if (priority < CanardPriorityNominal) {
+        return LOAD_CLASS_HIGH;
+    }
+    return (priority == CanardPriorityNominal) ? LOAD_CLASS_NOMINAL : LOAD_CLASS_LOW;
+}
+
+/* 传输占用的比特数, 多帧传输按满帧计, FD 单帧按 DLC 取整后的长度计 */
+static uint32_t transfer_bits(size_t payload_size)
+{
+    if (payload_size + 1U <= CAN_IFACE_MTU) {
+        return can_frame_bits(can_dlc_to_bytes(can_bytes_to_dlc((uint8_t)(payload_size + 1U))));
+    }
+    //每帧 MTU-1 字节数据 + 1 字节尾, 末尾 2 字节 CRC
+    const size_t frames = (payload_size + 2U + CAN_IFACE_MTU - 2U) / (CAN_IFACE_MTU - 1U);
+
+    return (uint32_t)frames * can_frame_bits(CAN_IFACE_MTU);
+}
+
+static void load_set_budgets(uint32_t scale_permille)
+{
+    for (size_t c = 0; c < LOAD_CLASS_COUNT; c++) {
+        uint64_t b = LOAD_WINDOW_BITS * class_budget_pct[c] / 100U;
+
+        if (c != LOAD_CLASS_HIGH) {
+            b = b * scale_permille / 1000U;
+        }
+        gov.budget[c] = (uint32_t)b;
+        gov.used[c] = 0;
+    }
+}
+
+void canard_load_update(void)
+{
+    const int64_t now = k_uptime_get();
+
+    if (!gov.started) {
+        gov.started = true;
+        gov.window_start = now;
+        load_set_budgets(1000U);
+        return;
+    }
+
+    const int64_t elapsed = now - gov.window_start;
+    if (elapsed < LOAD_WINDOW_MS) {
+        return;
+    }
+
+    const uint64_t capacity = (uint64_t)can_bitrate * (uint64_t)elapsed / 1000U;
+    uint32_t busiest = 0;
+
+    for (uint8_t i = 0; i < CAN_IFACE_COUNT; i++) {
+        busiest = MAX(busiest, (uint32_t)atomic_clear(&can_iface_stats[i].bus_bits));
+    }
+    const uint32_t load = (uint32_t)MIN((uint64_t)busiest * 1000U / capacity, 1000U);
+    const uint32_t tx = (uint32_t)MIN((uint64_t)gov.tx_bits * 1000U / capacity, 1000U);
+
+    gov.load_ema += ((int32_t)load - (int32_t)gov.load_ema) / LOAD_EMA_DIV;
+
+    // 超过目标负载时按比例压缩 Nominal 及以下的预算
+    const uint32_t target = CONFIG_CANARD_BUS_LOAD_TARGET_PCT * 10U;
+    const bool throttling = gov.load_ema > target;
+
+    if (throttling != stats.throttling) {
+        LOG_WRN("Bus load %u.%u%%, TX budgets %s", gov.load_ema / 10U, gov.load_ema % 10U,
+                throttling ? "reduced" : "restored");
+    }
+    load_set_budgets(throttling ? target * 1000U / gov.load_ema : 1000U);
+
+    stats.bus_permille = (uint16_t)gov.load_ema;
+    stats.tx_permille = (uint16_t)tx;
+    stats.throttling = throttling;
+    gov.tx_bits = 0;
+    gov.window_start = now;
+}
+
+bool canard_load_admit(CanardPriority priority, bool governed, size_t payload_size)
+{
+    const enum load_class c = load_class_of(priority);
+    const uint32_t bits = transfer_bits(payload_size);
+
+    // 窗口内第一个传输总是放行, 保证大于预算的传输也能发出
+    if (governed && c != LOAD_CLASS_HIGH && gov.used[c] != 0U && gov.used[c] + bits > gov.budget[c]) {
+        stats.deferred++;
+        return false;
+    }
+    gov.used[c] += bits;
+    gov.tx_bits += bits;  //冗余模式下每个接口各发一份, 与单接口负载同口径
+    return true;
+}
+
+const struct canard_load_stats *canard_load_stats(void)
+{
+    return &stats;
+}
+
+void canard_load_encode(uint8_t buf[CANARD_LOAD_STATUS_SIZE])
+{
+    sys_put_le16(stats.bus_permille, &buf[0]);
+    sys_put_le16(stats.tx_permille, &buf[2]);
+    sys_put_le16((uint16_t)stats.deferred, &buf[4]);
+    buf[6] = stats.throttling ? BIT(0) : 0U;
+}
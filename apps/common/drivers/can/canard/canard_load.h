@@ -0,0 +1,61 @@
+/**
+ * @file canard_load.h
+ * @brief Bus load meter and per-priority TX budgets
+ *
+ * Bus utilization is measured from the frames seen by the CAN driver
+ * (received plus own transmissions) over fixed windows. Outgoing
+ * messages are charged against a per-priority bit budget; once a
+ * budget is spent the message is refused and the publisher retries
+ * later. While the measured load exceeds CONFIG_CANARD_BUS_LOAD_TARGET_PCT
+ * the Nominal and lower budgets shrink proportionally. Service responses
+ * are always admitted.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CANARD_LOAD_H_
+#define CANARD_LOAD_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "canard.h"
+
+/* 诊断消息长度, 单帧 */
+#define CANARD_LOAD_STATUS_SIZE 7U
+
+/**
+ * @struct canard_load_stats
+ * @brief Result of the last completed measurement window
+ */
+struct canard_load_stats {
+    uint16_t bus_permille;   ///< Load of the busiest interface
+    uint16_t tx_permille;    ///< Share of that load caused by this node
+    uint32_t deferred;       ///< Messages refused since boot
+    bool throttling;         ///< Budgets currently scaled down
+};
+
+/** @brief Close the window when due and recompute budgets (canard thread) */
+void canard_load_update(void);
+
+/**
+ * @brief Charge a transfer against its priority budget (canard thread)
+ * @param governed false for service transfers, charged but never refused
+ * @retval true send it
+ * @retval false budget spent, try again in a later window
+ */
+bool canard_load_admit(CanardPriority priority, bool governed, size_t payload_size);
+
+const struct canard_load_stats *canard_load_stats(void);
+
+/**
+ * @brief Serialize the diagnostics message
+ *
+ *   [0..1] bus load, permille, u16 LE
+ *   [2..3] own TX load, permille, u16 LE
+ *   [4..5] deferred messages, u16 LE, wrapping
+ *   [6]    bit0: throttling
+ */
+void canard_load_encode(uint8_t buf[CANARD_LOAD_STATUS_SIZE]);
+
+#endif /* CANARD_LOAD_H_ */
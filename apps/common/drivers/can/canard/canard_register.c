@@ -0,0 +1,372 @@
+/**
+ * @file canard_register.c
+ * @brief uavcan.register interface backed by the settings subsystem
+ *
+ * Register values are only written by the canard thread (Access requests)
+ * and by the settings loader before any request is served. The save work
+ * item runs on the system work queue and copies values under a spinlock,
+ * so a multi-element register is never stored half updated.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#if defined(CONFIG_SETTINGS)
+#include <zephyr/settings/settings.h>
+#endif
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <uavcan/_register/Access_1_0.h>
+#include <uavcan/_register/List_1_0.h>
+#include "canard_register.h"
+#include "canard_time.h"
+
+LOG_MODULE_REGISTER(canard_register, LOG_LEVEL_INF);
+
+#define REGISTER_KEY_MAX   64U
+
+static const struct canard_register *regs;
+static size_t reg_count;
+static uint32_t reg_loaded;     // 启动时从 settings 恢复的条目
+static atomic_t reg_dirty;      // 待写入 flash 的条目
+static struct k_spinlock reg_lock;
+
+static size_t reg_size(const struct canard_register *reg)
+{
+    return (size_t)reg->count * CANARD_REGISTER_ELEM_SIZE(reg->type);
+}
+
+static double reg_get(const struct canard_register *reg, const void *buf, size_t i)
+{
+    switch (reg->type) {
+    case CANARD_REGISTER_NATURAL16:
+        return ((const uint16_t *)buf)[i];
+    case CANARD_REGISTER_NATURAL32:
+        return ((const uint32_t *)buf)[i];
+    default:
+        return ((const float *)buf)[i];
+    }
+}
+
+static void reg_put(const struct canard_register *reg, void *buf, size_t i, double x)
+{
+    switch (reg->type) {
+    case CANARD_REGISTER_NATURAL16:
+        ((uint16_t *)buf)[i] = (uint16_t)x;
+        break;
+    case CANARD_REGISTER_NATURAL32:
+        ((uint32_t *)buf)[i] = (uint32_t)x;
+        break;
+    default:
+        ((float *)buf)[i] = (float)x;
+        break;
+    }
+}
+
+static bool reg_elem_ok(const struct canard_register *reg, double x)
+{
+    if (isnan(x)) {
+        return reg->type == CANARD_REGISTER_REAL32 && (reg->flags & CANARD_REGISTER_NAN) != 0U;
+    }
+    if (x < reg->min || x > reg->max) {
+        return false;
+    }
+    // 整数寄存器不接受小数, 避免静默截断
+    return reg->type == CANARD_REGISTER_REAL32 || x == floor(x);
+}
+
+static bool reg_valid(const struct canard_register *reg, const void *buf)
+{
+    for (size_t i = 0; i < reg->count; i++) {
+        if (!reg_elem_ok(reg, reg_get(reg, buf, i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void reg_store(const struct canard_register *reg, const void *buf)
+{
+    k_spinlock_key_t key = k_spin_lock(&reg_lock);
+
+    memcpy(reg->value, buf, reg_size(reg));
+    k_spin_unlock(&reg_lock, key);
+}
+
+static int reg_find(const uint8_t *name, size_t len)
+{
+    for (size_t i = 0; i < reg_count; i++) {
+        if (strlen(regs[i].name) == len && memcmp(regs[i].name, name, len) == 0) {
+            return (int)i;
+        }
+    }
+    return -ENOENT;
+}
+
+#if defined(CONFIG_SETTINGS)
+static int reg_settings_set(const char *name, size_t len,
+                            settings_read_cb read_cb, void *cb_arg)
+{
+    uint32_t buf[CANARD_REGISTER_MAX_COUNT];   // 按 4 字节对齐
+
+    for (size_t i = 0; i < reg_count; i++) {
+        const struct canard_register *reg = &regs[i];
+        const char *next;
+
+        if (!settings_name_steq(name, reg->name, &next) || next != NULL) {
+            continue;
+        }
+        // 固件改变了寄存器形状时丢弃旧值
+        if (len != reg_size(reg)) {
+            return -EINVAL;
+        }
+        const ssize_t rc = read_cb(cb_arg, buf, len);
+        if (rc < 0) {
+            return (int)rc;
+        }
+        if (!reg_valid(reg, buf)) {
+            LOG_WRN("Stored %s out of range, default kept", reg->name);
+            return -EINVAL;
+        }
+        reg_store(reg, buf);
+        reg_loaded |= BIT(i);
+        return 0;
+    }
+    return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(canard_register, "reg", NULL, reg_settings_set, NULL, NULL);
+
+/* flash 擦写可能耗时数百毫秒, 放到工作队列并合并连续写入 */
+static void reg_save(struct k_work *work)
+{
+    const uint32_t dirty = (uint32_t)atomic_clear(&reg_dirty);
+    uint32_t buf[CANARD_REGISTER_MAX_COUNT];
+    char key[REGISTER_KEY_MAX];
+
+    ARG_UNUSED(work);
+    for (size_t i = 0; i < reg_count; i++) {
+        const struct canard_register *reg = &regs[i];
+
+        if ((dirty & BIT(i)) == 0U) {
+            continue;
+        }
+        k_spinlock_key_t lock = k_spin_lock(&reg_lock);
+
+        memcpy(buf, reg->value, reg_size(reg));
+        k_spin_unlock(&reg_lock, lock);
+
+        snprintf(key, sizeof(key), "reg/%s", reg->name);
+        const int ret = settings_save_one(key, buf, reg_size(reg));
+        if (ret < 0) {
+            LOG_WRN("Failed to store %s (err %d)", reg->name, ret);
+        }
+    }
+}
+
+static K_WORK_DELAYABLE_DEFINE(reg_save_work, reg_save);
+#endif
+
+int canard_register_init(const struct canard_register *table, size_t count)
+{
+    if (count > CANARD_REGISTER_MAX_ENTRIES) {
+        return -EINVAL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (table[i].count == 0U || table[i].count > CANARD_REGISTER_MAX_COUNT) {
+            return -EINVAL;
+        }
+    }
+    regs = table;
+    reg_count = count;
+
+#if defined(CONFIG_SETTINGS)
+    int ret = settings_subsys_init();
+    if (ret == 0) {
+        ret = settings_load_subtree("reg");
+    }
+    if (ret < 0) {
+        LOG_WRN("Settings unavailable (err %d), registers not restored", ret);
+    }
+#endif
+    for (size_t i = 0; i < reg_count; i++) {
+        const struct canard_register *reg = &regs[i];
+
+        if ((reg_loaded & BIT(i)) != 0U && reg->apply != NULL && reg->apply(reg) < 0) {
+            LOG_WRN("Stored %s not applied", reg->name);
+        }
+    }
+    LOG_INF("%u registers, %u restored", (unsigned)reg_count, (unsigned)POPCOUNT(reg_loaded));
+    return 0;
+}
+
+/* 把任意数值类型的 Value 转为 double, 非数值类型或元素过多时返回 false */
+static bool value_to_double(const uavcan_register_Value_1_0 *v, double *out, size_t *n)
+{
+#define VALUE_TAKE(kind)                                                         \
+    if (uavcan_register_Value_1_0_is_##kind##_(v)) {                             \
+        if (v->kind.value.count > CANARD_REGISTER_MAX_COUNT) {                   \
+            return false;                                                        \
+        }                                                                        \
+        for (size_t i = 0; i < v->kind.value.count; i++) {                       \
+            out[i] = (double)v->kind.value.elements[i];                          \
+        }                                                                        \
+        *n = v->kind.value.count;                                                \
+        return true;                                                             \
+    }
+    VALUE_TAKE(natural8)
+    VALUE_TAKE(natural16)
+    VALUE_TAKE(natural32)
+    VALUE_TAKE(natural64)
+    VALUE_TAKE(integer8)
+    VALUE_TAKE(integer16)
+    VALUE_TAKE(integer32)
+    VALUE_TAKE(integer64)
+    VALUE_TAKE(real16)
+    VALUE_TAKE(real32)
+    VALUE_TAKE(real64)
+#undef VALUE_TAKE
+    return false;
+}
+
+static int reg_write(size_t idx, const uavcan_register_Value_1_0 *v)
+{
+    const struct canard_register *reg = &regs[idx];
+    double in[CANARD_REGISTER_MAX_COUNT];
+    uint32_t buf[CANARD_REGISTER_MAX_COUNT];
+    uint32_t old[CANARD_REGISTER_MAX_COUNT];
+    size_t n = 0;
+
+    if ((reg->flags & CANARD_REGISTER_MUTABLE) == 0U) {
+        return -EPERM;
+    }
+    if (!value_to_double(v, in, &n) || n != reg->count) {
+        return -EINVAL;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (!reg_elem_ok(reg, in[i])) {
+            return -ERANGE;
+        }
+        reg_put(reg, buf, i, in[i]);
+    }
+    memcpy(old, reg->value, reg_size(reg));
+    reg_store(reg, buf);
+    if ((reg->flags & CANARD_REGISTER_RESTART) == 0U && reg->apply != NULL) {
+        const int ret = reg->apply(reg);
+        if (ret < 0) {
+            reg_store(reg, old);
+            return ret;
+        }
+    }
+#if defined(CONFIG_SETTINGS)
+    if ((reg->flags & CANARD_REGISTER_PERSISTENT) != 0U) {
+        atomic_or(&reg_dirty, BIT(idx));
+        k_work_reschedule(&reg_save_work, K_MSEC(CONFIG_CANARD_REGISTER_SAVE_DELAY_MS));
+    }
+#endif
+    return 0;
+}
+
+int canard_register_update(const void *value, const void *buf)
+{
+    for (size_t i = 0; i < reg_count; i++) {
+        const struct canard_register *reg = &regs[i];
+
+        if (reg->value != value) {
+            continue;
+        }
+        reg_store(reg, buf);
+#if defined(CONFIG_SETTINGS)
+        if ((reg->flags & CANARD_REGISTER_PERSISTENT) != 0U) {
+            atomic_or(&reg_dirty, BIT(i));
+            k_work_reschedule(&reg_save_work, K_MSEC(CONFIG_CANARD_REGISTER_SAVE_DELAY_MS));
+        }
+#endif
+        return 0;
+    }
+    return -ENOENT;
+}
+
+static void reg_read(const struct canard_register *reg, uavcan_register_Value_1_0 *v)
+{
+    switch (reg->type) {
+    case CANARD_REGISTER_NATURAL16:
+        uavcan_register_Value_1_0_select_natural16_(v);
+        memcpy(v->natural16.value.elements, reg->value, reg_size(reg));
+        v->natural16.value.count = reg->count;
+        break;
+    case CANARD_REGISTER_NATURAL32:
+        uavcan_register_Value_1_0_select_natural32_(v);
+        memcpy(v->natural32.value.elements, reg->value, reg_size(reg));
+        v->natural32.value.count = reg->count;
+        break;
+    default:
+        uavcan_register_Value_1_0_select_real32_(v);
+        memcpy(v->real32.value.elements, reg->value, reg_size(reg));
+        v->real32.value.count = reg->count;
+        break;
+    }
+}
+
+size_t canard_register_access(const uint8_t *req, size_t len, uint8_t *resp, size_t size)
+{
+    // 约 600 字节, 只在 canard 线程中使用, 不放在栈上
+    static uavcan_register_Access_Request_1_0 rq;
+    static uavcan_register_Access_Response_1_0 rs;
+    size_t in_size = len;
+    size_t out_size = size;
+
+    if (uavcan_register_Access_Request_1_0_deserialize_(&rq, req, &in_size) < 0) {
+        return 0;
+    }
+    uavcan_register_Access_Response_1_0_initialize_(&rs);
+
+    // 未知寄存器按规范回复 empty
+    const int idx = reg_find(rq.name.name.elements, rq.name.name.count);
+    if (idx >= 0) {
+        const struct canard_register *reg = &regs[idx];
+
+        if (!uavcan_register_Value_1_0_is_empty_(&rq.value)) {
+            const int ret = reg_write((size_t)idx, &rq.value);
+            if (ret < 0) {
+                LOG_WRN("Write to %s rejected: %d", reg->name, ret);
+            }
+        }
+        rs.timestamp.microsecond = canard_time_synced() ? canard_time_sync_usec() : 0U;
+        rs._mutable = (reg->flags & CANARD_REGISTER_MUTABLE) != 0U;
+        rs.persistent = IS_ENABLED(CONFIG_SETTINGS) &&
+                        (reg->flags & CANARD_REGISTER_PERSISTENT) != 0U;
+        reg_read(reg, &rs.value);
+    }
+    if (uavcan_register_Access_Response_1_0_serialize_(&rs, resp, &out_size) < 0) {
+        return 0;
+    }
+    return out_size;
+}
+
+size_t canard_register_list(const uint8_t *req, size_t len, uint8_t *resp, size_t size)
+{
+    uavcan_register_List_Request_1_0 rq;
+    static uavcan_register_List_Response_1_0 rs;
+    size_t in_size = len;
+    size_t out_size = size;
+
+    if (uavcan_register_List_Request_1_0_deserialize_(&rq, req, &in_size) < 0) {
+        return 0;
+    }
+    uavcan_register_List_Response_1_0_initialize_(&rs);
+
+    // 索引越界时回复空名称, 客户端据此结束枚举
+    if (rq.index < reg_count) {
+        const char *name = regs[rq.index].name;
+
+        rs.name.name.count = MIN(strlen(name), uavcan_register_Name_1_0_name_ARRAY_CAPACITY_);
+        memcpy(rs.name.name.elements, name, rs.name.name.count);
+    }
+    if (uavcan_register_List_Response_1_0_serialize_(&rs, resp, &out_size) < 0) {
+        return 0;
+    }
+    return out_size;
+}
@@ -0,0 +1,121 @@
+/**
+ * @file canard_register.h
+ * @brief uavcan.register interface backed by the settings subsystem
+ *
+ * The application describes its tunable parameters in a constant table;
+ * every entry points at the plain variable the rest of the code reads, so
+ * hot paths never go through the register layer. uavcan.register.Access
+ * reads or writes one entry, uavcan.register.List enumerates the names.
+ *
+ * Writes are checked against the element count and range before they
+ * reach the variable; a rejected write leaves the value unchanged and the
+ * response carries the current value, as the Access semantics require.
+ * Numeric values of any uavcan.register.Value type are converted to the
+ * register type.
+ *
+ * Persistent registers are stored under "reg/<name>" when CONFIG_SETTINGS
+ * is enabled. Flash is not written per request: a write marks the entry
+ * dirty and one delayed work item saves all dirty entries
+ * CONFIG_CANARD_REGISTER_SAVE_DELAY_MS after the last write, so a
+ * configuration tool setting many registers in a row costs one flash
+ * update burst.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CANARD_REGISTER_H_
+#define CANARD_REGISTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+#define CANARD_REGISTER_MAX_COUNT 4U    ///< Elements per register
+#define CANARD_REGISTER_MAX_ENTRIES 32U
+
+enum canard_register_type {
+    CANARD_REGISTER_NATURAL16 = 0,
+    CANARD_REGISTER_NATURAL32,
+    CANARD_REGISTER_REAL32,
+};
+
+#define CANARD_REGISTER_MUTABLE    BIT(0)
+#define CANARD_REGISTER_PERSISTENT BIT(1)
+#define CANARD_REGISTER_NAN        BIT(2)   ///< real32 elements may be NaN
+#define CANARD_REGISTER_RESTART    BIT(3)   ///< apply() only runs at boot
+
+struct canard_register;
+
+/**
+ * @brief Hand a new value to its users
+ *
+ * Called after a successful write, and at boot when a stored value was
+ * loaded. For CANARD_REGISTER_RESTART entries only the boot call happens,
+ * the written value waits in the variable for the next start.
+ * @return Negative errno to reject a write, the previous value is restored
+ */
+typedef int (*canard_register_apply_t)(const struct canard_register *reg);
+
+/**
+ * @struct canard_register
+ * @brief One table entry
+ */
+struct canard_register {
+    const char *name;
+    void *value;                      ///< count elements of type
+    uint8_t type;                     ///< enum canard_register_type
+    uint8_t count;
+    uint8_t flags;
+    float min;                        ///< Per element, inclusive
+    float max;
+    canard_register_apply_t apply;    ///< Optional
+};
+
+#define CANARD_REGISTER_ELEM_SIZE(type) \
+    (((type) == CANARD_REGISTER_NATURAL16) ? sizeof(uint16_t) : sizeof(uint32_t))
+
+/* count 由变量大小推出, 标量与数组写法相同 */
+#define CANARD_REGISTER_ENTRY(name_, var_, type_, flags_, min_, max_, apply_) {     \
+    .name = (name_),                                                             \
+    .value = &(var_),                                                            \
+    .type = (type_),                                                             \
+    .count = sizeof(var_) / CANARD_REGISTER_ELEM_SIZE(type_),                    \
+    .flags = (flags_),                                                           \
+    .min = (min_),                                                               \
+    .max = (max_),                                                               \
+    .apply = (apply_),                                                           \
+}
+
+/**
+ * @brief Attach the table and restore stored values (canard thread, before can_init)
+ *
+ * The table must stay valid for the lifetime of the program.
+ */
+int canard_register_init(const struct canard_register *table, size_t count);
+
+/**
+ * @brief Store a value changed through another interface (canard thread)
+ *
+ * For variables that a service can also set, so that the register reads
+ * back what is in effect. The value is persisted like an Access write;
+ * apply() is not called, the caller has already handed it to its users.
+ *
+ * @param value Variable of a table entry
+ * @param buf New value, count elements of the entry type
+ * @retval -ENOENT @p value belongs to no entry
+ */
+int canard_register_update(const void *value, const void *buf);
+
+/**
+ * @brief Handle a serialized uavcan.register.Access request (canard thread)
+ * @return Response length written to @p resp, 0 when no response is due
+ */
+size_t canard_register_access(const uint8_t *req, size_t len, uint8_t *resp, size_t size);
+
+/**
+ * @brief Handle a serialized uavcan.register.List request (canard thread)
+ * @return Response length written to @p resp, 0 when no response is due
+ */
+size_t canard_register_list(const uint8_t *req, size_t len, uint8_t *resp, size_t size);
+
+#endif /* CANARD_REGISTER_H_ */
@@ -0,0 +1,169 @@
+/**
+ * @file canard_sched.c
+ * @brief Periodic publication scheduler for the canard thread
+ *
+ * Hashed timer wheel: an entry due at tick t lives in slot t % WHEEL_SLOTS
+ * and is skipped by the cursor until t is reached, so periods longer
+ * than one revolution need no special handling. Releases are counted
+ * from the nominal schedule, a late or deferred run does not shift the
+ * following ones. Everything runs in the canard thread, no locking.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include "canard_sched.h"
+#include "canard_time.h"
+
+LOG_MODULE_REGISTER(canard_sched, LOG_LEVEL_INF);
+
+#define WHEEL_SLOTS 64U
+#define WHEEL_MASK  (WHEEL_SLOTS - 1U)
+BUILD_ASSERT((WHEEL_SLOTS & WHEEL_MASK) == 0U, "WHEEL_SLOTS must be a power of two");
+
+static struct canard_sched_entry *wheel[WHEEL_SLOTS];
+static uint8_t phase_use[CANARD_SCHED_STAGGER_MS];  //各相位上已注册的条目数
+static int64_t cursor = -1;                         //下一个待处理的 tick
+
+static int64_t sched_now(void)
+{
+    return (int64_t)(canard_time_local_usec() / 1000U);
+}
+
+static void wheel_insert(struct canard_sched_entry *e, int64_t due)
+{
+    struct canard_sched_entry **slot = &wheel[due & WHEEL_MASK];
+
+    e->due = due;
+    e->next = *slot;
+    *slot = e;
+}
+
+static void wheel_remove(struct canard_sched_entry *e)
+{
+    for (struct canard_sched_entry **pp = &wheel[e->due & WHEEL_MASK]; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == e) {
+            *pp = e->next;
+            e->next = NULL;
+            return;
+        }
+    }
+}
+
+static uint32_t sched_pick_phase(uint32_t period_ms)
+{
+    const uint32_t span = MIN(period_ms, CANARD_SCHED_STAGGER_MS);
+    uint32_t best = 0;
+
+    for (uint32_t p = 1; p < span; p++) {
+        if (phase_use[p] < phase_use[best]) {
+            best = p;
+        }
+    }
+    return best;
+}
+
+int canard_sched_add(struct canard_sched_entry *e)
+{
+    if (e->fn == NULL || e->period_ms == 0U) {
+        return -EINVAL;
+    }
+    if (e->phase_ms == CANARD_SCHED_PHASE_AUTO) {
+        e->phase_ms = sched_pick_phase(e->period_ms);
+    }
+    e->phase_ms %= CANARD_SCHED_STAGGER_MS;
+    phase_use[e->phase_ms]++;
+
+    const int64_t now = sched_now();
+    if (cursor < 0) {
+        cursor = now;
+    }
+    // 首次释放对齐到下一个同相位的网格点
+    int64_t first = now - (now % CANARD_SCHED_STAGGER_MS) + e->phase_ms;
+    if (first < now) {
+        first += CANARD_SCHED_STAGGER_MS;
+    }
+    e->base = first;
+    wheel_insert(e, first);
+    LOG_DBG("%s: period %u ms, phase %u ms", e->name, e->period_ms, e->phase_ms);
+    return 0;
+}
+
+static void sched_jitter_update(struct canard_sched_entry *e, uint64_t now_us)
+{
+    const uint64_t release_us = (uint64_t)e->base * 1000U;
+    const uint32_t lat = (now_us > release_us) ? (uint32_t)MIN(now_us - release_us, UINT32_MAX) : 0U;
+
+    e->jitter_last_us = lat;
+    e->jitter_max_us = MAX(e->jitter_max_us, lat);
+    e->jitter_avg_us = (e->runs == 0U) ? lat :
+                       e->jitter_avg_us + (int32_t)(lat - e->jitter_avg_us) / 16;
+}
+
+static void sched_fire(struct canard_sched_entry *e, int64_t tick, int64_t now)
+{
+    const uint64_t now_us = canard_time_local_usec();
+
+    if (!e->fn(e->arg)) {
+        // 追赶时 tick 落后于 now, 排到 now 之后, 每次 poll 最多重试一次
+        e->deferred++;
+        wheel_insert(e, MAX(tick + 1, now + 1));
+        return;
+    }
+    sched_jitter_update(e, now_us);
+    e->runs++;
+
+    // 落后超过一个周期时跳过错过的释放点, 保持原相位
+    int64_t next = e->base + e->period_ms;
+    if (next <= tick) {
+        next += ((tick - next) / e->period_ms + 1) * e->period_ms;
+    }
+    e->base = next;
+    wheel_insert(e, next);
+}
+
+void canard_sched_poll(void)
+{
+    if (cursor < 0) {
+        return;
+    }
+    const int64_t now = sched_now();
+
+    // 停顿超过一圈时只需把每个槽各扫一遍
+    if (now - cursor >= (int64_t)WHEEL_SLOTS) {
+        cursor = now - WHEEL_SLOTS + 1;
+    }
+    for (; cursor <= now; cursor++) {
+        struct canard_sched_entry **pp = &wheel[cursor & WHEEL_MASK];
+
+        while (*pp != NULL) {
+            struct canard_sched_entry *e = *pp;
+
+            if (e->due > cursor) {
+                pp = &e->next;
+                continue;
+            }
+            *pp = e->next;
+            // 重新插入的条目 due 一定大于 cursor, 不会在本轮再次触发
+            sched_fire(e, cursor, now);
+        }
+    }
+}
+
+void canard_sched_kick(struct canard_sched_entry *e)
+{
+    if (cursor < 0) {
+        return;
+    }
+    wheel_remove(e);
+    e->base = cursor;
+    wheel_insert(e, cursor);
+}
+
+void canard_sched_set_period(struct canard_sched_entry *e, uint32_t period_ms)
+{
+    if (period_ms != 0U) {
+        e->period_ms = period_ms;
+    }
+}
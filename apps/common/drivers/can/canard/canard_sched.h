@@ -0,0 +1,84 @@
+/**
+ * @file canard_sched.h
+ * @brief Periodic publication scheduler for the canard thread
+ *
+ * Publications register a callback, a period and a phase. Entries sit in
+ * a hashed timer wheel with 1 ms slots; canard_sched_poll() only visits
+ * the slots that elapsed since the previous call, so the cost does not
+ * grow with the number of registered publications.
+ *
+ * Phases are relative to a CANARD_SCHED_STAGGER_MS grid: with periods
+ * that are multiples of the grid, entries of different phases never
+ * fire in the same millisecond. CANARD_SCHED_PHASE_AUTO picks the least
+ * used phase.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CANARD_SCHED_H_
+#define CANARD_SCHED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CANARD_SCHED_STAGGER_MS  10U
+#define CANARD_SCHED_PHASE_AUTO  UINT32_MAX
+
+/**
+ * @brief Publication callback
+ * @return false if nothing was sent (e.g. TX budget spent); the entry is
+ *         retried on the next millisecond without losing its phase
+ */
+typedef bool (*canard_sched_fn_t)(void *arg);
+
+/**
+ * @struct canard_sched_entry
+ * @brief One periodic publication, statically allocated by its owner
+ */
+struct canard_sched_entry {
+    const char *name;
+    canard_sched_fn_t fn;
+    void *arg;
+    uint32_t period_ms;
+    uint32_t phase_ms;          ///< CANARD_SCHED_PHASE_AUTO or < CANARD_SCHED_STAGGER_MS
+
+    /* 以下由调度器维护 */
+    struct canard_sched_entry *next;
+    int64_t base;               ///< Nominal release tick (ms)
+    int64_t due;                ///< Slot tick, later than base while deferred
+    uint32_t runs;
+    uint32_t deferred;
+    uint32_t jitter_last_us;    ///< Release-to-callback delay of the last run
+    uint32_t jitter_max_us;
+    uint32_t jitter_avg_us;     ///< 指数滑动平均, 1/16
+};
+
+#define CANARD_SCHED_ENTRY(_name, _fn, _arg, _period_ms, _phase_ms) { \
+    .name = (_name),                                                 \
+    .fn = (_fn),                                                     \
+    .arg = (_arg),                                                   \
+    .period_ms = (_period_ms),                                       \
+    .phase_ms = (_phase_ms),                                         \
+}
+
+/**
+ * @brief Register a publication (canard thread)
+ * @retval 0 scheduled, first release at the next tick matching its phase
+ * @retval -EINVAL zero period or missing callback
+ */
+int canard_sched_add(struct canard_sched_entry *e);
+
+/** @brief Run every entry that became due (canard thread, once per loop) */
+void canard_sched_poll(void);
+
+/**
+ * @brief Release @p e on the next poll and restart its period from there
+ *
+ * Used for event-driven publications that also have a refresh period.
+ */
+void canard_sched_kick(struct canard_sched_entry *e);
+
+/** @brief Change the period, effective from the next release */
+void canard_sched_set_period(struct canard_sched_entry *e, uint32_t period_ms);
+
+#endif /* CANARD_SCHED_H_ */
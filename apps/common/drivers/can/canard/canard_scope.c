@@ -0,0 +1,325 @@
+/**
+ * @file canard_scope.c
+ * @brief Triggered capture of control loop variables
+ *
+ * The canard thread owns the configuration and only touches it while
+ * the state is IDLE or DONE; the motor thread owns the ring buffer while
+ * ARMED or TRIGGERED. The state variable is the only shared field.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#include <string.h>
+#include <lib/bldcmotor/motor.h>
+#include "canard_scope.h"
+#include "canard_time.h"
+
+LOG_MODULE_REGISTER(canard_scope, LOG_LEVEL_INF);
+
+#define SCOPE_CHANNELS CONFIG_CANARD_SCOPE_CHANNELS
+#define SCOPE_RESP_HEADER 4U
+
+static float ring[CONFIG_CANARD_SCOPE_BUFFER_SIZE];
+static atomic_t scope_state = ATOMIC_INIT(CANARD_SCOPE_IDLE);
+static atomic_t command_seen;
+static atomic_t force_trigger;
+
+static struct {
+    /* 配置, 由 canard 线程在 IDLE/DONE 状态下写入 */
+    uint8_t nch;
+    uint8_t vars[SCOPE_CHANNELS];
+    uint8_t trigger;
+    uint8_t trig_ch;
+    float threshold;
+    uint16_t depth;        //每通道样本数
+    uint16_t pre;
+    uint8_t decimation;
+
+    /* 采样状态, 由电机线程在 ARMED/TRIGGERED 状态下写入 */
+    uint16_t widx;
+    uint16_t filled;
+    uint16_t post_left;
+    uint8_t div_cnt;
+    float prev_trig;
+    bool have_prev;
+    float last_pos[SCOPE_CHANNELS];  //SPEED 通道各自的上一位置
+    uint32_t last_cycles;
+    uint64_t first_us;
+    uint64_t end_us;
+    uint32_t recorded;
+} scope;
+
+static float var_position(const struct device *motor)
+{
+    return motor_get_curposi(motor);
+}
+
+static float var_mode(const struct device *motor)
+{
+    return (float)motor_get_mode(motor);
+}
+
+static float var_state(const struct device *motor)
+{
+    return (float)motor_get_state(motor);
+}
+
+static float var_motor_fsm(const struct device *motor)
+{
+    const struct motor_config *cfg = motor->config;
+
+    return (float)cfg->fsm->chState;
+}
+
+static canard_scope_getter_t getters[CANARD_SCOPE_VAR_COUNT] = {
+    [CANARD_SCOPE_VAR_POSITION] = var_position,
+    [CANARD_SCOPE_VAR_MODE] = var_mode,
+    [CANARD_SCOPE_VAR_STATE] = var_state,
+    [CANARD_SCOPE_VAR_MOTOR_FSM] = var_motor_fsm,
+};
+
+int canard_scope_register(uint8_t id, canard_scope_getter_t get)
+{
+    if (id < CANARD_SCOPE_VAR_APP || id >= CANARD_SCOPE_VAR_COUNT) {
+        return -EINVAL;
+    }
+    getters[id] = get;
+    return 0;
+}
+
+void canard_scope_command_event(void)
+{
+    atomic_set(&command_seen, 1);
+}
+
+static float scope_read_var(uint8_t ch, const struct device *motor, uint32_t now_cycles)
+{
+    const uint8_t var = scope.vars[ch];
+
+    if (var == CANARD_SCOPE_VAR_SPEED) {
+        const float pos = motor_get_curposi(motor);
+        const uint32_t dt = now_cycles - scope.last_cycles;
+        float speed = 0.0f;
+
+        if (scope.recorded > 0U && dt != 0U) {
+            speed = (pos - scope.last_pos[ch]) * (float)sys_clock_hw_cycles_per_sec() / (float)dt;
+        }
+        scope.last_pos[ch] = pos;
+        return speed;
+    }
+    return (getters[var] != NULL) ? getters[var](motor) : 0.0f;
+}
+
+static bool scope_triggered(const float *v)
+{
+    const float x = v[scope.trig_ch];
+    const bool forced = atomic_clear(&force_trigger) != 0;
+    bool hit = false;
+
+    switch (scope.trigger) {
+    case CANARD_SCOPE_TRIG_NOW:
+        hit = true;
+        break;
+    case CANARD_SCOPE_TRIG_RISING:
+        hit = scope.have_prev && scope.prev_trig < scope.threshold && x >= scope.threshold;
+        break;
+    case CANARD_SCOPE_TRIG_FALLING:
+        hit = scope.have_prev && scope.prev_trig > scope.threshold && x <= scope.threshold;
+        break;
+    case CANARD_SCOPE_TRIG_CHANGE:
+        hit = scope.have_prev && x != scope.prev_trig;
+        break;
+    case CANARD_SCOPE_TRIG_COMMAND:
+        hit = atomic_clear(&command_seen) != 0;
+        break;
+    default:
+        break;
+    }
+    scope.prev_trig = x;
+    scope.have_prev = true;
+    return hit || forced;
+}
+
+void canard_scope_sample(const struct device *motor)
+{
+    const atomic_val_t st = atomic_get(&scope_state);
+
+    if (st != CANARD_SCOPE_ARMED && st != CANARD_SCOPE_TRIGGERED) {
+        return;
+    }
+    if (++scope.div_cnt < scope.decimation) {
+        return;
+    }
+    scope.div_cnt = 0;
+
+    const uint32_t now = k_cycle_get_32();
+    float *slot = &ring[(size_t)scope.widx * scope.nch];
+
+    for (uint8_t ch = 0; ch < scope.nch; ch++) {
+        slot[ch] = scope_read_var(ch, motor, now);
+    }
+    if (scope.recorded == 0U) {
+        scope.first_us = canard_time_local_usec();
+    }
+    scope.last_cycles = now;
+    scope.recorded++;
+    scope.widx = (scope.widx + 1U == scope.depth) ? 0U : scope.widx + 1U;
+    scope.filled = MIN(scope.filled + 1U, scope.depth);
+
+    if (st == CANARD_SCOPE_ARMED) {
+        // 预触发部分填满之前不检查触发条件
+        if (scope.filled > scope.pre && scope_triggered(slot)) {
+            scope.post_left = scope.depth - scope.pre - 1U;
+            atomic_set(&scope_state, CANARD_SCOPE_TRIGGERED);
+        } else {
+            return;
+        }
+    } else {
+        scope.post_left--;
+    }
+    if (scope.post_left == 0U) {
+        scope.end_us = canard_time_local_usec();
+        atomic_set(&scope_state, CANARD_SCOPE_DONE);
+    }
+}
+
+static int scope_arm(const uint8_t *req, size_t len)
+{
+    const atomic_val_t st = atomic_get(&scope_state);
+
+    if (st == CANARD_SCOPE_ARMED || st == CANARD_SCOPE_TRIGGERED) {
+        return -EBUSY;
+    }
+    if (len < 2U) {
+        return -EINVAL;
+    }
+    const uint8_t nch = req[1];
+    if (nch == 0U || nch > SCOPE_CHANNELS || len < 2U + nch + 9U) {
+        return -EINVAL;
+    }
+    const uint8_t *p = &req[2 + nch];
+    const uint8_t trigger = p[0];
+    const uint8_t trig_ch = p[1];
+    const uint32_t thr_raw = sys_get_le32(&p[2]);
+    const uint16_t pre = sys_get_le16(&p[6]);
+    const uint8_t decimation = p[8];
+    const uint16_t depth = CONFIG_CANARD_SCOPE_BUFFER_SIZE / nch;
+
+    if (trigger > CANARD_SCOPE_TRIG_COMMAND || trig_ch >= nch || pre >= depth) {
+        return -EINVAL;
+    }
+    for (uint8_t ch = 0; ch < nch; ch++) {
+        const uint8_t var = req[2 + ch];
+        if (var >= CANARD_SCOPE_VAR_COUNT ||
+            (var != CANARD_SCOPE_VAR_SPEED && getters[var] == NULL)) {
+            return -ENOENT;
+        }
+        scope.vars[ch] = var;
+    }
+    scope.nch = nch;
+    scope.trigger = trigger;
+    scope.trig_ch = trig_ch;
+    memcpy(&scope.threshold, &thr_raw, sizeof(scope.threshold));
+    scope.depth = depth;
+    scope.pre = pre;
+    scope.decimation = MAX(decimation, 1U);
+    scope.widx = 0;
+    scope.filled = 0;
+    scope.div_cnt = 0;
+    scope.have_prev = false;
+    scope.recorded = 0;
+    atomic_clear(&command_seen);
+    atomic_clear(&force_trigger);
+    atomic_set(&scope_state, CANARD_SCOPE_ARMED);
+    LOG_INF("Armed: %u ch x %u samples, trigger %u, pre %u", nch, depth, trigger, pre);
+    return 0;
+}
+
+static size_t scope_status(uint8_t *resp)
+{
+    const atomic_val_t st = atomic_get(&scope_state);
+    uint32_t period_us = 0;
+
+    if (st == CANARD_SCOPE_DONE && scope.recorded > 1U) {
+        period_us = (uint32_t)((scope.end_us - scope.first_us) / (scope.recorded - 1U));
+    }
+    resp[0] = 0;
+    resp[1] = (uint8_t)st;
+    resp[2] = scope.nch;
+    resp[3] = scope.decimation;
+    sys_put_le16((st == CANARD_SCOPE_DONE) ? scope.depth : scope.filled, &resp[4]);
+    sys_put_le16(scope.pre, &resp[6]);
+    sys_put_le32(period_us, &resp[8]);
+    return 12U;
+}
+
+static size_t scope_read(const uint8_t *req, size_t len, uint8_t *resp, size_t size)
+{
+    if (atomic_get(&scope_state) != CANARD_SCOPE_DONE) {
+        resp[0] = ENODATA;
+        return 1U;
+    }
+    if (len < 3U) {
+        resp[0] = EINVAL;
+        return 1U;
+    }
+    const uint16_t first = sys_get_le16(&req[1]);
+    const size_t per_sample = (size_t)scope.nch * sizeof(float);
+    const size_t fit = (MIN(size, CONFIG_CANARD_SCOPE_CHUNK_BYTES) - SCOPE_RESP_HEADER) / per_sample;
+    const uint16_t n = (first < scope.depth) ? (uint16_t)MIN(fit, (size_t)(scope.depth - first)) : 0U;
+    uint8_t *p = &resp[SCOPE_RESP_HEADER];
+
+    // 读出顺序从最旧样本开始, 触发点位于第 pre 个样本
+    for (uint16_t i = 0; i < n; i++) {
+        const size_t idx = ((size_t)scope.widx + first + i) % scope.depth;
+        const float *slot = &ring[idx * scope.nch];
+
+        for (uint8_t ch = 0; ch < scope.nch; ch++) {
+            uint32_t raw;
+
+            memcpy(&raw, &slot[ch], sizeof(raw));
+            sys_put_le32(raw, p);
+            p += sizeof(raw);
+        }
+    }
+    resp[0] = 0;
+    sys_put_le16(first, &resp[1]);
+    resp[3] = (uint8_t)n;
+    return SCOPE_RESP_HEADER + (size_t)n * per_sample;
+}
+
+size_t canard_scope_handle(const uint8_t *req, size_t len, uint8_t *resp, size_t size)
+{
+    int ret = 0;
+
+    if (len < 1U || size < CONFIG_CANARD_SCOPE_CHUNK_BYTES) {
+        return 0;
+    }
+    switch (req[0]) {
+    case CANARD_SCOPE_OP_STATUS:
+        return scope_status(resp);
+    case CANARD_SCOPE_OP_ARM:
+        ret = scope_arm(req, len);
+        break;
+    case CANARD_SCOPE_OP_ABORT:
+        atomic_set(&scope_state, CANARD_SCOPE_IDLE);
+        break;
+    case CANARD_SCOPE_OP_READ:
+        return scope_read(req, len, resp, size);
+    case CANARD_SCOPE_OP_FORCE:
+        if (atomic_get(&scope_state) == CANARD_SCOPE_ARMED) {
+            atomic_set(&force_trigger, 1);
+        } else {
+            ret = -EALREADY;
+        }
+        break;
+    default:
+        ret = -ENOTSUP;
+        break;
+    }
+    resp[0] = (uint8_t)(-ret);
+    return 1U;
+}
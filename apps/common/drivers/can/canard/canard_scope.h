@@ -0,0 +1,91 @@
+/**
+ * @file canard_scope.h
+ * @brief Triggered capture of control loop variables
+ *
+ * The host selects up to CONFIG_CANARD_SCOPE_CHANNELS variables, a
+ * trigger and a pre-trigger depth, then arms the scope. The motor thread
+ * records one sample per control loop (optionally decimated) into a ring
+ * buffer until the trigger fires and the post-trigger part is full. The
+ * capture is then read back in chunks through a raw service on
+ * CONFIG_CANARD_SCOPE_SERVICE_ID. While disarmed the motor thread hook
+ * returns after a single atomic load.
+ *
+ * Requests (byte 0 is the opcode, multi-byte fields little endian):
+ *   STATUS  -> [0] err [1] state [2] channels [3] decimation
+ *              [4..5] samples [6..7] trigger index [8..11] sample period us
+ *   ARM     [1] nch [2..] var ids, then trigger type, trigger channel,
+ *           threshold f32, pre-trigger samples u16, decimation u8
+ *           -> [0] err
+ *   ABORT   -> [0] err
+ *   READ    [1..2] first sample u16
+ *           -> [0] err [1..2] first sample [3] n, n samples of nch f32
+ *   FORCE   -> [0] err, triggers an armed capture now
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CANARD_SCOPE_H_
+#define CANARD_SCOPE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+
+/* 最长的请求是 ARM: 操作码, 通道数, 变量号, 以及 9 字节触发参数 */
+#define CANARD_SCOPE_REQUEST_EXTENT (2U + CONFIG_CANARD_SCOPE_CHANNELS + 9U)
+
+enum canard_scope_op {
+    CANARD_SCOPE_OP_STATUS = 0,
+    CANARD_SCOPE_OP_ARM = 1,
+    CANARD_SCOPE_OP_ABORT = 2,
+    CANARD_SCOPE_OP_READ = 3,
+    CANARD_SCOPE_OP_FORCE = 4,
+};
+
+enum canard_scope_state {
+    CANARD_SCOPE_IDLE = 0,
+    CANARD_SCOPE_ARMED,       ///< Filling the pre-trigger part, waiting for the trigger
+    CANARD_SCOPE_TRIGGERED,   ///< Recording the post-trigger part
+    CANARD_SCOPE_DONE,        ///< Capture complete, ready for READ
+};
+
+enum canard_scope_trigger {
+    CANARD_SCOPE_TRIG_NOW = 0,       ///< Trigger on the first sample
+    CANARD_SCOPE_TRIG_RISING = 1,    ///< Channel crosses threshold upwards
+    CANARD_SCOPE_TRIG_FALLING = 2,   ///< Channel crosses threshold downwards
+    CANARD_SCOPE_TRIG_CHANGE = 3,    ///< Channel value changes (state variables)
+    CANARD_SCOPE_TRIG_COMMAND = 4,   ///< A motion command was received
+};
+
+/* 内置变量, 应用变量从 CANARD_SCOPE_VAR_APP 开始注册 */
+enum canard_scope_var {
+    CANARD_SCOPE_VAR_POSITION = 0,   ///< motor_get_curposi()
+    CANARD_SCOPE_VAR_SPEED = 1,      ///< Position difference per second between samples
+    CANARD_SCOPE_VAR_MODE = 2,       ///< motor_get_mode()
+    CANARD_SCOPE_VAR_STATE = 3,      ///< motor_get_state()
+    CANARD_SCOPE_VAR_MOTOR_FSM = 4,  ///< chState of the motor FSM
+    CANARD_SCOPE_VAR_APP = 8,
+    CANARD_SCOPE_VAR_COUNT = 16,
+};
+
+typedef float (*canard_scope_getter_t)(const struct device *motor);
+
+/**
+ * @brief Make an application variable available to the scope
+ * @retval -EINVAL @p id outside CANARD_SCOPE_VAR_APP..CANARD_SCOPE_VAR_COUNT-1
+ */
+int canard_scope_register(uint8_t id, canard_scope_getter_t get);
+
+/** @brief Record a sample if armed (motor thread, every control loop) */
+void canard_scope_sample(const struct device *motor);
+
+/** @brief Note a received motion command for CANARD_SCOPE_TRIG_COMMAND */
+void canard_scope_command_event(void);
+
+/**
+ * @brief Handle one scope service request (canard thread)
+ * @return Response length written to @p resp
+ */
+size_t canard_scope_handle(const uint8_t *req, size_t len, uint8_t *resp, size_t size);
+
+#endif /* CANARD_SCOPE_H_ */
@@ -0,0 +1,131 @@
+/**
+ * @file canard_telemetry.c
+ * @brief Motor state telemetry stream
+ *
+ * Single producer (motor thread) / single consumer (canard thread), no
+ * locks. Sampling is paced on the local clock so the rate does not
+ * depend on the control loop period; timestamps are bus time so samples
+ * from different nodes can be merged on the host.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/spsc_lockfree.h>
+#include <string.h>
+#include <lib/bldcmotor/motor.h>
+#include "canard_telemetry.h"
+#include "canard_time.h"
+
+#define TELEMETRY_PERIOD_US (1000000U / CONFIG_CANARD_TELEMETRY_RATE_HZ)
+
+BUILD_ASSERT((CONFIG_CANARD_TELEMETRY_QUEUE_DEPTH & (CONFIG_CANARD_TELEMETRY_QUEUE_DEPTH - 1)) == 0,
+             "CONFIG_CANARD_TELEMETRY_QUEUE_DEPTH must be a power of two");
+
+struct telemetry_sample {
+    uint32_t time_us;
+    float position;
+    float speed;
+    uint8_t mode;
+    uint8_t state;
+};
+
+SPSC_DEFINE(telemetry_q, struct telemetry_sample, CONFIG_CANARD_TELEMETRY_QUEUE_DEPTH);
+
+/* 采样端状态, 仅电机线程访问 */
+static uint64_t next_sample_us;
+static uint64_t last_sample_us;
+static float last_position;
+static bool have_last;
+static atomic_t dropped;
+
+/* 发送端状态, 仅 canard 线程访问 */
+static uint8_t pending[CANARD_TELEMETRY_MAX_SIZE];
+static size_t pending_len;
+static uint8_t sequence;
+
+void canard_telemetry_sample(const struct device *motor)
+{
+    const uint64_t now = canard_time_local_usec();
+
+    if (now < next_sample_us) {
+        return;
+    }
+    // 控制循环被阻塞过久时不补采, 从当前时刻重新计时
+    next_sample_us += TELEMETRY_PERIOD_US;
+    if (next_sample_us <= now) {
+        next_sample_us = now + TELEMETRY_PERIOD_US;
+    }
+
+    const float position = motor_get_curposi(motor);
+    float speed = 0.0f;
+
+    if (have_last && now > last_sample_us) {
+        speed = (position - last_position) * 1e6f / (float)(now - last_sample_us);
+    }
+    last_position = position;
+    last_sample_us = now;
+    have_last = true;
+
+    struct telemetry_sample *s = spsc_acquire(&telemetry_q);
+    if (s == NULL) {
+        atomic_inc(&dropped);
+        return;
+    }
+    s->time_us = (uint32_t)canard_time_sync_usec();
+    s->position = position;
+    s->speed = speed;
+    s->mode = (uint8_t)motor_get_mode(motor);
+    s->state = (uint8_t)motor_get_state(motor);
+    spsc_produce(&telemetry_q);
+}
+
+static void put_float(float v, uint8_t *p)
+{
+    uint32_t raw;
+
+    memcpy(&raw, &v, sizeof(raw));
+    sys_put_le32(raw, p);
+}
+
+size_t canard_telemetry_encode(uint8_t *buf, size_t size)
+{
+    if (size < CANARD_TELEMETRY_MAX_SIZE) {
+        return 0;
+    }
+    if (pending_len == 0U) {
+        uint8_t n = 0;
+        uint8_t *p = &pending[CANARD_TELEMETRY_HEADER_SIZE];
+        const struct telemetry_sample *s;
+
+        while (n < CONFIG_CANARD_TELEMETRY_BATCH && (s = spsc_consume(&telemetry_q)) != NULL) {
+            sys_put_le32(s->time_us, &p[0]);
+            put_float(s->position, &p[4]);
+            put_float(s->speed, &p[8]);
+            pending[2] = s->mode;
+            pending[3] = s->state;
+            spsc_release(&telemetry_q);
+            p += CANARD_TELEMETRY_SAMPLE_SIZE;
+            n++;
+        }
+        if (n == 0U) {
+            return 0;
+        }
+        pending[0] = sequence++;
+        pending[1] = n;
+        pending_len = CANARD_TELEMETRY_HEADER_SIZE + (size_t)n * CANARD_TELEMETRY_SAMPLE_SIZE;
+    }
+    memcpy(buf, pending, pending_len);
+    return pending_len;
+}
+
+void canard_telemetry_sent(void)
+{
+    pending_len = 0;
+}
+
+uint32_t canard_telemetry_dropped(void)
+{
+    return (uint32_t)atomic_get(&dropped);
+}
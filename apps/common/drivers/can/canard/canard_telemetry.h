@@ -0,0 +1,64 @@
+/**
+ * @file canard_telemetry.h
+ * @brief Motor state telemetry stream
+ *
+ * The motor thread samples the drive at CONFIG_CANARD_TELEMETRY_RATE_HZ
+ * into a lock-free queue; the canard thread packs up to
+ * CONFIG_CANARD_TELEMETRY_BATCH samples per message on subject
+ * CONFIG_CANARD_TELEMETRY_PORT_ID.
+ *
+ * Message layout (little endian):
+ *   [0]    sequence, increments per message
+ *   [1]    sample count n
+ *   [2]    motor_get_mode() of the last sample
+ *   [3]    motor_get_state() of the last sample
+ *   then n samples of 12 bytes:
+ *   [0..3]  bus time, low 32 bits, microseconds
+ *   [4..7]  position, float32, motor_get_curposi()
+ *   [8..11] speed, float32, position units per second, differentiated
+ *           over the sampling interval
+ *
+ * lib/bldcmotor/motor.h only exposes position, mode and state, so the
+ * measured speed, phase current and DC-bus voltage of the drive cannot
+ * be carried; the speed above is derived from position.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CANARD_TELEMETRY_H_
+#define CANARD_TELEMETRY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/sys/util.h>
+
+#define CANARD_TELEMETRY_HEADER_SIZE 4U
+#define CANARD_TELEMETRY_SAMPLE_SIZE 12U
+#define CANARD_TELEMETRY_MAX_SIZE \
+    (CANARD_TELEMETRY_HEADER_SIZE + CANARD_TELEMETRY_SAMPLE_SIZE * CONFIG_CANARD_TELEMETRY_BATCH)
+
+/* 每条消息的发布周期, 至少 1ms */
+#define CANARD_TELEMETRY_PERIOD_MS \
+    MAX(1U, (1000U * CONFIG_CANARD_TELEMETRY_BATCH) / CONFIG_CANARD_TELEMETRY_RATE_HZ)
+
+/** @brief Take a sample when due (motor thread, every control loop) */
+void canard_telemetry_sample(const struct device *motor);
+
+/**
+ * @brief Build the next message (canard thread)
+ *
+ * A message that could not be sent stays pending and is returned again
+ * until canard_telemetry_sent() is called.
+ *
+ * @return Message length, 0 if no sample is available
+ */
+size_t canard_telemetry_encode(uint8_t *buf, size_t size);
+
+/** @brief Release the pending message after a successful push */
+void canard_telemetry_sent(void);
+
+/** @brief Samples lost because the queue was full */
+uint32_t canard_telemetry_dropped(void);
+
+#endif /* CANARD_TELEMETRY_H_ */
@@ -0,0 +1,127 @@
+/**
+ * @file canard_time.c
+ * @brief uavcan.time.Synchronization slave
+ *
+ * Each sync message carries the master's transmission time of the
+ * previous message. Pairing it with the local reception time of that
+ * previous message, when both share the same master and consecutive
+ * transfer IDs, yields the clock offset. Large errors are stepped,
+ * small ones are slewed to keep timestamps monotonic.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#include "canard_time.h"
+
+LOG_MODULE_REGISTER(canard_time, LOG_LEVEL_INF);
+
+#define SYNC_MASTER_TIMEOUT_USEC  3000000U  //主站超时后允许切换到其他主站
+#define SYNC_STEP_THRESHOLD_USEC  10000     //误差超过 10ms 直接跳变
+#define SYNC_SLEW_SHIFT           2         //小误差每次修正 1/4
+
+static struct {
+    int64_t offset;               //bus = local + offset
+    bool synced;
+    CanardNodeID master;
+    CanardTransferID last_tid;
+    uint64_t last_rx_local;       //上一条同步消息的本地接收时间
+    bool have_last;
+} sync = {
+    .master = CANARD_NODE_ID_UNSET,
+};
+
+/* 32 位硬件周期计数器扩展为 64 位, 两次调用间隔需小于一次回绕 */
+static struct k_spinlock clock_lock;
+static uint32_t cycle_last;
+static uint64_t cycle_high;
+
+static uint64_t canard_time_cycles64(uint32_t *now32)
+{
+    k_spinlock_key_t key = k_spin_lock(&clock_lock);
+    const uint32_t now = k_cycle_get_32();
+
+    if (now < cycle_last) {
+        cycle_high += 1ULL << 32;
+    }
+    cycle_last = now;
+    const uint64_t cycles = cycle_high | now;
+    k_spin_unlock(&clock_lock, key);
+
+    if (now32 != NULL) {
+        *now32 = now;
+    }
+    return cycles;
+}
+
+uint64_t canard_time_local_usec(void)
+{
+    return k_cyc_to_us_floor64(canard_time_cycles64(NULL));
+}
+
+uint64_t canard_time_from_cycles(uint32_t cycles)
+{
+    uint32_t now32;
+    const uint64_t now = canard_time_cycles64(&now32);
+
+    return k_cyc_to_us_floor64(now - (uint32_t)(now32 - cycles));
+}
+
+uint64_t canard_time_sync_usec(void)
+{
+    return (uint64_t)((int64_t)canard_time_local_usec() + sync.offset);
+}
+
+uint64_t canard_time_to_local(uint64_t sync_usec)
+{
+    return (uint64_t)((int64_t)sync_usec - sync.offset);
+}
+
+bool canard_time_synced(void)
+{
+    return sync.synced;
+}
+
+void canard_time_on_sync(const CanardRxTransfer *transfer)
+{
+    const CanardNodeID src = transfer->metadata.remote_node_id;
+    const CanardTransferID tid = transfer->metadata.transfer_id;
+    const uint64_t rx_local = transfer->timestamp_usec;
+
+    if (transfer->payload_size < CANARD_TIME_SYNC_EXTENT || src == CANARD_NODE_ID_UNSET) {
+        return;
+    }
+
+    /* 只跟随节点号最小的主站, 当前主站超时后才接受其他主站 */
+    if (sync.master != CANARD_NODE_ID_UNSET && src != sync.master) {
+        const bool timed_out = rx_local - sync.last_rx_local > SYNC_MASTER_TIMEOUT_USEC;
+        if (src > sync.master && !timed_out) {
+            return;
+        }
+        LOG_INF("Time sync master %u -> %u", sync.master, src);
+        sync.have_last = false;
+    }
+    sync.master = src;
+
+    const uint8_t *p = transfer->payload;
+    const uint64_t prev_tx = (uint64_t)sys_get_le32(p) | ((uint64_t)sys_get_le24(p + 4) << 32);
+
+    if (sync.have_last && prev_tx != 0U &&
+        tid == (CanardTransferID)((sync.last_tid + 1U) & 31U)) {
+        const int64_t offset = (int64_t)prev_tx - (int64_t)sync.last_rx_local;
+        const int64_t error = offset - sync.offset;
+
+        if (!sync.synced || error > SYNC_STEP_THRESHOLD_USEC || error < -SYNC_STEP_THRESHOLD_USEC) {
+            sync.offset = offset;
+            sync.synced = true;
+        } else {
+            sync.offset += error >> SYNC_SLEW_SHIFT;
+        }
+    }
+
+    sync.last_tid = tid;
+    sync.last_rx_local = rx_local;
+    sync.have_last = true;
+}
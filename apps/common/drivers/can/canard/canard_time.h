@@ -0,0 +1,44 @@
+/**
+ * @file canard_time.h
+ * @brief uavcan.time.Synchronization slave
+ *
+ * Tracks the offset between the local monotonic clock and the bus time
+ * master. Until a master has been heard the synchronized time equals the
+ * local time.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef CANARD_TIME_H_
+#define CANARD_TIME_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "canard.h"
+
+/* uavcan.time.Synchronization.1.0 */
+#define CANARD_TIME_SYNC_PORT_ID     7168U
+#define CANARD_TIME_SYNC_EXTENT      7U
+
+/** @brief Local monotonic time in microseconds */
+uint64_t canard_time_local_usec(void);
+
+/**
+ * @brief Convert a k_cycle_get_32() value latched within the last few
+ * seconds (e.g. in an ISR) to local microseconds
+ */
+uint64_t canard_time_from_cycles(uint32_t cycles);
+
+/** @brief Bus (synchronized) time in microseconds */
+uint64_t canard_time_sync_usec(void);
+
+/** @brief Convert a bus timestamp to the local time base */
+uint64_t canard_time_to_local(uint64_t sync_usec);
+
+/** @brief True once an offset has been established from a master */
+bool canard_time_synced(void);
+
+/** @brief Feed a received uavcan.time.Synchronization transfer */
+void canard_time_on_sync(const CanardRxTransfer *transfer);
+
+#endif /* CANARD_TIME_H_ */
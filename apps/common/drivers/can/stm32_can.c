@@ -0,0 +1,247 @@
+#include <zephyr/device.h>
+#include <zephyr/drivers/can.h>
+#include <zephyr/kernel.h>
+#include <string.h>
+#include <zephyr/sys/printk.h>
+#include <zephyr/drivers/can.h>
+#include <zephyr/logging/log.h>
+#include "stm32_can.h"
+#include "hot_path.h"
+#include "log_rl.h"
+#if defined(CONFIG_CANARD_BLACKBOX)
+#include "canard/canard_blackbox.h"
+#endif
+LOG_MODULE_REGISTER(stm32_can, LOG_LEVEL_DBG);
+
+/* 启动时等待控制器状态切换的上限, 正常情况下在一个 tick 内完成 */
+#define CAN_INIT_TIMEOUT_MS 50U
+
+const struct device *const can_devs[CAN_IFACE_COUNT] = {
+    DEVICE_DT_GET(DT_NODELABEL(fdcan1)),
+#if defined(CONFIG_CANARD_REDUNDANT_IFACE)
+    DEVICE_DT_GET(DT_NODELABEL(fdcan2)),
+#endif
+};
+
+struct can_iface_stats can_iface_stats[CAN_IFACE_COUNT];
+
+uint32_t can_bitrate = CAN_BITRATE;
+#if defined(CONFIG_CANARD_FD)
+uint32_t can_data_bitrate = CAN_DATA_BITRATE;
+#endif
+
+// 前置声明
+static void can_rx_callback(const struct device *dev, struct can_frame *frame, void *user_data);
+
+/* 两个队列都要存下一个轮询间隔内到达的帧, 0 按此取值, 更小的固定值编译失败 */
+#if CONFIG_CANARD_RX_QUEUE_HI_LEN > 0
+#define RX_MSGQ_HI_LEN CONFIG_CANARD_RX_QUEUE_HI_LEN
+#else
+#define RX_MSGQ_HI_LEN CAN_RX_BURST
+#endif
+#if CONFIG_CANARD_RX_QUEUE_LEN > 0
+#define RX_MSGQ_LEN    CONFIG_CANARD_RX_QUEUE_LEN
+#else
+#define RX_MSGQ_LEN    CAN_RX_BURST
+#endif
+BUILD_ASSERT(RX_MSGQ_HI_LEN >= CAN_RX_BURST && RX_MSGQ_LEN >= CAN_RX_BURST,
+             "CAN RX queues cannot hold the frames arriving between two polls");
+
+/* 队列缓冲区按 hot_path.h 放置, 发布配置下在 DTCM, 由 can_init 初始化 */
+static char APP_HOT_NOINIT __aligned(4) rx_msgq_hi_buf[RX_MSGQ_HI_LEN * sizeof(struct can_rx_item)];
+static char APP_HOT_NOINIT __aligned(4) rx_msgq_buf[RX_MSGQ_LEN * sizeof(struct can_rx_item)];
+struct k_msgq rx_msgq_hi;
+struct k_msgq rx_msgq;
+
+#if defined(CONFIG_APP_CYCLE_STATS)
+struct cycle_stats can_rx_isr_cycles;
+#endif
+
+static uint8_t can_iface_index(const struct device *dev)
+{
+    for (uint8_t i = 0; i < CAN_IFACE_COUNT; i++) {
+        if (can_devs[i] == dev) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+static void can_state_callback(const struct device *dev, enum can_state state,
+                               struct can_bus_err_cnt err_cnt, void *user_data)
+{
+    struct can_iface_stats *st = user_data;
+
+    ARG_UNUSED(err_cnt);
+    st->state = state;
+    if (state == CAN_STATE_BUS_OFF) {
+        st->bus_off++;
+    }
+#if defined(CONFIG_CANARD_BLACKBOX)
+    canard_blackbox_record(CANARD_BLACKBOX_CAN_STATE, can_iface_index(dev), (uint16_t)state);
+#else
+    ARG_UNUSED(dev);
+#endif
+}
+
+static void can_tx_callback(const struct device *dev, int error, void *user_data)
+{
+    struct can_iface_stats *st = user_data;
+
+    ARG_UNUSED(dev);
+    if (error == 0) {
+        atomic_inc(&st->tx_done);
+    } else {
+        atomic_inc(&st->tx_err);
+    }
+}
+
+/*
+ * 控制器运行中 can_set_mode 返回 -EBUSY. 按实际状态轮询, 不用固定延时,
+ * 看门狗复位后节点应尽快回到总线上.
+ */
+static int can_set_mode_wait(const struct device *dev, can_mode_t mode)
+{
+    const int64_t deadline = k_uptime_get() + CAN_INIT_TIMEOUT_MS;
+    int ret;
+
+    while ((ret = can_set_mode(dev, mode)) == -EBUSY) {
+        if (k_uptime_get() >= deadline) {
+            return -ETIMEDOUT;
+        }
+        k_sleep(K_TICKS(1));
+    }
+    return ret;
+}
+
+static int can_iface_init(uint8_t iface, const struct can_filter *critical, size_t count)
+{
+    const struct device *dev = can_devs[iface];
+
+    if (!device_is_ready(dev)) {
+        LOG_INF("dev %u no ready", iface);
+        return -ENODEV;
+    }
+    // 停止 CAN 设备, 返回时控制器已进入初始化模式; 复位后本来就是停止状态
+    int ret = can_stop(dev);
+    if (ret < 0 && ret != -EALREADY) {
+        return ret;
+    }
+
+    struct can_timing timing;
+    ret = can_calc_timing(dev, &timing, can_bitrate, 875); // 10kbps, 87.5%采样点
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = can_set_timing(dev, &timing);
+    if (ret < 0) {
+        return ret;
+    }
+
+#if defined(CONFIG_CANARD_FD)
+    // 数据段波特率, 发送帧带 BRS
+    struct can_timing timing_data;
+    ret = can_calc_timing_data(dev, &timing_data, can_data_bitrate, 750);
+    if (ret < 0) {
+        return ret;
+    }
+
+    ret = can_set_timing_data(dev, &timing_data);
+    if (ret < 0) {
+        return ret;
+    }
+    const int mode = CAN_MODE_FD;
+#else
+    const int mode = CAN_MODE_NORMAL;
+#endif
+
+    // 设置模式前确保控制器就绪
+    ret = can_set_mode_wait(dev, mode);
+    if (ret < 0) {
+        return ret;
+    }
+
+    // LOG_INF("can init finish");
+
+    // 硬件按过滤器序号匹配, 先命中者生效, 因此关键过滤器必须先于全通过滤器安装
+    for (size_t i = 0; i < count; i++) {
+        int ret_hi = can_add_rx_filter(dev, can_rx_callback, &rx_msgq_hi, &critical[i]);
+        if (ret_hi < 0) {
+            LOG_ERR("Failed to add critical filter %u (err %d)", (unsigned)i, ret_hi);
+        }
+    }
+
+    struct can_filter filter = {
+        .id = 0x00000000,  // 匹配所有标准ID
+        .mask = 0x00000000,  // 掩码全0表示不检查任何位
+        .flags = CAN_FILTER_IDE  // 明确指定标准帧
+    };
+    int filter_id = can_add_rx_filter(dev, can_rx_callback, &rx_msgq, &filter);
+    LOG_INF("Added filter %d (id=0x%x mask=0x%x)", filter_id, filter.id, filter.mask);
+
+    // 打印硬件状态
+    uint32_t core_clock;
+    can_get_core_clock(dev, &core_clock);
+    // LOG_INF("CAN core clock: %u Hz", core_clock);
+
+    can_set_state_change_callback(dev, can_state_callback, &can_iface_stats[iface]);
+    return can_start(dev);
+}
+
+int can_init(const struct can_filter *critical, size_t count)
+{
+    int up = 0;
+    int ret = -ENODEV;
+
+    k_msgq_init(&rx_msgq_hi, rx_msgq_hi_buf, sizeof(struct can_rx_item), RX_MSGQ_HI_LEN);
+    k_msgq_init(&rx_msgq, rx_msgq_buf, sizeof(struct can_rx_item), RX_MSGQ_LEN);
+
+    // 冗余模式下任一接口可用即可工作, 另一接口的故障只记录
+    for (uint8_t i = 0; i < CAN_IFACE_COUNT; i++) {
+        ret = can_iface_init(i, critical, count);
+        if (ret < 0) {
+            LOG_ERR("CAN iface %u init failed (err %d)", i, ret);
+            can_iface_stats[i].state = CAN_STATE_STOPPED;
+        } else {
+            up++;
+        }
+    }
+    return (up > 0) ? 0 : ret;
+}
+
+int can_iface_send(uint8_t iface, const struct can_frame *frame)
+{
+    struct can_iface_stats *st = &can_iface_stats[iface];
+
+    if (st->state == CAN_STATE_BUS_OFF || st->state == CAN_STATE_STOPPED) {
+        return -ENETDOWN;
+    }
+    // 不等待发送邮箱, 邮箱满时由调用者下一轮重试
+    int ret = can_send(can_devs[iface], frame, K_NO_WAIT, can_tx_callback, st);
+    if (ret == 0) {
+        st->tx_queued++;
+        atomic_add(&st->bus_bits, can_frame_bits(can_dlc_to_bytes(frame->dlc)));
+    }
+    return ret;
+}
+
+static APP_HOT_TEXT void can_rx_callback(const struct device *dev, struct can_frame *frame, void *user_data)
+{
+    // 在中断中打时间戳, 排队延迟不计入接收时间
+    struct can_rx_item item = {
+        .rx_cycles = k_cycle_get_32(),
+        .iface = can_iface_index(dev),
+    };
+    item.frame = *frame;
+    atomic_add(&can_iface_stats[item.iface].bus_bits, can_frame_bits(can_dlc_to_bytes(frame->dlc)));
+    if (k_msgq_put((struct k_msgq *)user_data, &item, K_NO_WAIT) != 0) { // 非阻塞入队
+        can_iface_stats[item.iface].rx_overrun++;
+    }
+#if defined(CONFIG_APP_CYCLE_STATS)
+    cycle_stats_add(&can_rx_isr_cycles, item.rx_cycles);
+#endif
+#if defined(CONFIG_APP_LOG_RX_TRACE)
+    LOG_RL_DBG("RX iface %u id 0x%08x dlc %u", item.iface, frame->id, frame->dlc);
+#endif
+}
@@ -0,0 +1,126 @@
+/**
+ * @file stm32_can.h
+ * @brief FDCAN bring-up and RX queue shared with the canard thread
+ *
+ * With CONFIG_CANARD_REDUNDANT_IFACE both fdcan1 and fdcan2 are brought
+ * up; received frames carry the index of the interface they arrived on.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef STM32_CAN_H_
+#define STM32_CAN_H_
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/can.h>
+#include "hot_path.h"
+
+/**
+ * @struct can_rx_item
+ * @brief Received frame plus the cycle counter latched in the RX ISR
+ */
+struct can_rx_item {
+    struct can_frame frame;
+    uint32_t rx_cycles;   ///< k_cycle_get_32() at reception
+    uint8_t iface;        ///< Index into can_devs
+};
+
+/* 仲裁段波特率默认值, 运行时以 can_bitrate 为准 */
+#define CAN_BITRATE 1000000U
+
+#if defined(CONFIG_CANARD_FD)
+#define CAN_DATA_BITRATE ((uint32_t)CONFIG_CANARD_FD_DATA_BITRATE)
+#define CAN_IFACE_MTU    64U
+#else
+#define CAN_IFACE_MTU    8U
+#endif
+
+/* 实际使用的波特率, can_init() 之前可由寄存器 uavcan.can.bitrate 覆盖, 总线负载按此换算 */
+extern uint32_t can_bitrate;
+#if defined(CONFIG_CANARD_FD)
+extern uint32_t can_data_bitrate;
+#endif
+
+/*
+ * 扩展帧最坏情况位数, 以仲裁段位时间计, 含位填充, CRC 定界, ACK, EOF 与帧间隔
+ * (Davis et al., 2007). @p len 为数据字节数.
+ * FD 帧的数据段(ESI 至 CRC 定界)按 can_data_bitrate / can_bitrate 折算.
+ */
+static inline uint32_t can_frame_bits(uint8_t len)
+{
+#if defined(CONFIG_CANARD_FD)
+    const uint32_t crc = (len <= 16U) ? 17U : 21U;
+    uint32_t data = 5U + 8U * len;
+
+    data += (data - 1U) / 4U;
+    data += 4U + crc + (4U + crc + 3U) / 4U + 1U;
+    return 41U + 12U + (data * can_bitrate + can_data_bitrate - 1U) / can_data_bitrate;
+#else
+    return 54U + 8U * len + 13U + (54U + 8U * len - 1U) / 4U;
+#endif
+}
+
+/* 最短的 Cyphal 帧: 扩展帧 1 字节数据(尾字节), 不计位填充, 含帧间隔 */
+#define CAN_FRAME_BITS_MIN 76U
+/* 仲裁段波特率上限 (ISO 11898-1) */
+#define CAN_BITRATE_MAX 1000000U
+
+/* canard_thread 取接收队列的间隔 */
+#define CAN_RX_POLL_MS 1U
+/*
+ * 两次取队列之间最多到达的帧数: k_msleep 向上取整到 tick, 间隔最长为
+ * CAN_RX_POLL_MS 加一个 tick, 其间总线满载且全是最短的帧.
+ */
+#define CAN_RX_POLL_US \
+    (CAN_RX_POLL_MS * 1000U + DIV_ROUND_UP(1000000U, CONFIG_SYS_CLOCK_TICKS_PER_SEC))
+#define CAN_RX_BURST \
+    DIV_ROUND_UP(CAN_BITRATE_MAX / 1000U * CAN_RX_POLL_US / 1000U, CAN_FRAME_BITS_MIN)
+
+#if defined(CONFIG_CANARD_REDUNDANT_IFACE)
+#define CAN_IFACE_COUNT 2U
+#else
+#define CAN_IFACE_COUNT 1U
+#endif
+
+/**
+ * @struct can_iface_stats
+ * @brief Per-interface counters, updated from the driver callbacks
+ */
+struct can_iface_stats {
+    atomic_t tx_done;       ///< Frames acknowledged on the bus
+    atomic_t tx_err;        ///< Frames completed with an error
+    uint32_t tx_queued;     ///< Frames handed to the controller
+    uint32_t tx_drop;       ///< Frames dropped by the canard thread (deadline/bus down)
+    uint32_t rx_overrun;    ///< Frames lost because the RX queue was full
+    uint32_t bus_off;       ///< Bus-off events
+    atomic_t bus_bits;      ///< Bits seen on the bus (RX + own TX), cleared by the load meter
+    enum can_state state;   ///< Last reported controller state
+};
+
+extern const struct device *const can_devs[CAN_IFACE_COUNT];
+extern struct can_iface_stats can_iface_stats[CAN_IFACE_COUNT];
+/* 控制关键帧(由 can_init 的 critical 过滤器匹配)进入 rx_msgq_hi, 其余进入 rx_msgq */
+extern struct k_msgq rx_msgq_hi;
+extern struct k_msgq rx_msgq;
+#if defined(CONFIG_APP_CYCLE_STATS)
+extern struct cycle_stats can_rx_isr_cycles;   ///< can_rx_callback, both interfaces
+#endif
+
+/**
+ * @brief Bring up the CAN controller and install RX filters
+ * @param critical Filters routed to rx_msgq_hi, installed ahead of the
+ *                 catch-all filter so they win the hardware match
+ * @param count Number of entries in @p critical
+ */
+int can_init(const struct can_filter *critical, size_t count);
+
+/**
+ * @brief Hand one frame to interface @p iface without blocking
+ * @retval 0 queued in the controller
+ * @retval -EAGAIN no free TX mailbox, retry later
+ * @retval -ENETDOWN interface is bus-off or stopped
+ */
+int can_iface_send(uint8_t iface, const struct can_frame *frame);
+
+#endif /* STM32_CAN_H_ */
@@ -0,0 +1,126 @@
+/**
+ * @file elevator_if.h
+ * @brief Interface between the canard thread and the elevator state machine
+ *
+ * Commands flow canard_thread -> super_elevator_task through a bounded
+ * single-producer/single-consumer lock-free queue, completions flow back
+ * through a second one. Neither side ever blocks the other. The group
+ * status frames are exchanged by the canard thread as well.
+ *
+ * Implemented by the lift application; apps/super only provides
+ * super_elevator_state() for MovableAddons.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_ELEVATOR_IF_H_
+#define APP_ELEVATOR_IF_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* 与旧的 conctrl_cmd 取值保持一致 */
+enum elevator_cmd_type {
+    ELEVATOR_CMD_NONE = 0,
+    ELEVATOR_CMD_OPEN = 1,   ///< 顶升到远端
+    ELEVATOR_CMD_CLOSE = 2,  ///< 回到零点
+    ELEVATOR_CMD_MOVE_TO = 3,  ///< 移动到 height 指定的高度
+};
+
+enum elevator_result {
+    ELEVATOR_RESULT_OK = 0,
+    ELEVATOR_RESULT_ABORTED = 1,  ///< 超时被 canard_thread 取消, 电机已停
+    ELEVATOR_RESULT_FAIL = 2,     ///< 移动中堵转, 电机已停
+};
+
+/* 全行程高度, 与电机位置同单位 */
+#define ELEVATOR_HEIGHT_MAX 3000.0f
+
+/* OPEN 的顶升行程, (0, ELEVATOR_HEIGHT_MAX], 寄存器 elevator.rising_dis 重启后生效 */
+extern float elevator_rising_dis;
+
+/**
+ * @struct elevator_cmd
+ * @brief One queued lift command
+ */
+struct elevator_cmd {
+    uint8_t type;    ///< enum elevator_cmd_type
+    uint8_t req_id;  ///< Chosen by the producer, echoed back on completion
+    float height;    ///< Target height for ELEVATOR_CMD_MOVE_TO, 0..ELEVATOR_HEIGHT_MAX
+};
+
+/**
+ * @struct elevator_done
+ * @brief Completion record for a previously queued command
+ */
+struct elevator_done {
+    uint8_t req_id;
+    uint8_t result;  ///< enum elevator_result
+    int8_t state;    ///< super_elevator_state() at completion
+    float height;    ///< Measured height at completion
+};
+
+/**
+ * @brief Queue a lift command (canard thread only)
+ * @retval 0 queued
+ * @retval -ENOBUFS queue full, command not accepted
+ */
+int elevator_cmd_post(const struct elevator_cmd *cmd);
+
+/**
+ * @brief Fetch the next completion record (canard thread only)
+ * @retval 0 @p done filled
+ * @retval -EAGAIN nothing completed
+ */
+int elevator_done_get(struct elevator_done *done);
+
+/**
+ * @brief Check whether @p req_id has been taken by the state machine
+ *
+ * The completion timeout runs from this point, so commands waiting in
+ * the queue behind a long stroke do not expire (canard thread only).
+ */
+bool elevator_cmd_running(uint8_t req_id);
+
+/**
+ * @brief Ask the state machine to abort command @p req_id (canard thread only)
+ *
+ * Ignored unless @p req_id is the running command. Otherwise the drive
+ * is stopped at its current height and the command completes with
+ * ELEVATOR_RESULT_ABORTED.
+ */
+void elevator_cmd_cancel(uint8_t req_id);
+
+int8_t super_elevator_state(void);
+
+/**
+ * @brief Counter bumped on every change of super_elevator_state()
+ *
+ * Lets the publisher detect transitions without locking; compare with
+ * the value seen at the last publication.
+ */
+uint32_t super_elevator_state_seq(void);
+
+/** @brief Last measured lift height, 0 at the zero switch */
+float super_elevator_height(void);
+
+/* Group status frame size, fits a single classic CAN frame */
+#define ELEVATOR_GROUP_STATUS_SIZE 7U
+
+/** @brief Set the local node ID used for leader election */
+void elevator_group_init(uint8_t node_id);
+
+/**
+ * @brief Serialize the local status frame (canard thread)
+ * @return Number of bytes written, 0 if @p size is too small
+ */
+size_t elevator_group_encode(uint8_t *buf, size_t size);
+
+/** @brief Consume a status frame received from node @p src (canard thread) */
+void elevator_group_decode(uint8_t src, const uint8_t *buf, size_t len);
+
+/** @brief Status broadcast period, shorter while any member is moving */
+uint32_t elevator_group_period_ms(void);
+
+#endif /* APP_ELEVATOR_IF_H_ */
@@ -0,0 +1,59 @@
+/**
+ * @file hot_path.h
+ * @brief Placement and cycle accounting of the hot paths
+ *
+ * With CONFIG_APP_TCM_PLACEMENT (release.conf) the CAN RX callback, the
+ * frame reassembly and the motor task run from ITCM, the RX queues and
+ * the canard heap live in DTCM. Both are zero wait state and bypass the
+ * cache, so their timing does not depend on flash wait states or cache
+ * misses. DTCM is not reachable by DMA; only CPU-accessed data goes there.
+ * libcanard is external source; its receive path is compiled separately
+ * and moved to ITCM by renaming the function sections, see
+ * apps/common/CMakeLists.txt.
+ *
+ * With CONFIG_APP_CYCLE_STATS the same paths are timed with the cycle
+ * counter and reported periodically, the input of tools/build_report.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_HOT_PATH_H_
+#define APP_HOT_PATH_H_
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#if defined(CONFIG_APP_TCM_PLACEMENT)
+#include <zephyr/linker/section_tags.h>
+#define APP_HOT_TEXT   __itcm_section
+#define APP_HOT_BSS    __dtcm_bss_section
+#define APP_HOT_NOINIT __dtcm_noinit_section
+#else
+#define APP_HOT_TEXT
+#define APP_HOT_BSS
+#define APP_HOT_NOINIT __noinit
+#endif
+
+#if defined(CONFIG_APP_CYCLE_STATS)
+/**
+ * @struct cycle_stats
+ * @brief Cycles spent in one path, max and count restart every report
+ */
+struct cycle_stats {
+    uint32_t n;
+    uint32_t avg;   ///< 指数滑动平均, 1/16
+    uint32_t max;
+};
+
+static inline void cycle_stats_add(struct cycle_stats *st, uint32_t start)
+{
+    const uint32_t c = k_cycle_get_32() - start;
+
+    st->max = MAX(st->max, c);
+    st->avg = (st->avg == 0U) ? c : st->avg + (int32_t)(c - st->avg) / 16;
+    st->n++;
+}
+#endif
+
+#endif /* APP_HOT_PATH_H_ */
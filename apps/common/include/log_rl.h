@@ -0,0 +1,60 @@
+/**
+ * @file log_rl.h
+ * @brief Rate-limited logging for the hot paths
+ *
+ * LOG_RL_<LEVEL>() behaves like LOG_<LEVEL>() but emits at most one
+ * message per call site every CONFIG_APP_LOG_RL_PERIOD_MS. Messages in
+ * between are counted, per site and in log_rl_dropped; the per-site count
+ * follows the next message that gets through. Each site keeps its own
+ * state in static variables, so one site should only be reached from one
+ * context (a thread or one ISR).
+ *
+ * Sites above the module log level compile away like the plain macros.
+ * The check is a subtraction and a compare; argument evaluation and
+ * message packaging only happen when the message is emitted. With
+ * deferred logging the message is formatted later by the log thread, or
+ * on the host with dictionary output (release.conf).
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_LOG_RL_H_
+#define APP_LOG_RL_H_
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/logging/log.h>
+
+/** Messages suppressed by all sites since boot, reported in the canard_health diagnostics */
+extern atomic_t log_rl_dropped;
+
+/* __log_level 由 LOG_MODULE_REGISTER/DECLARE 定义, 为模块编译期日志等级 */
+#define LOG_RL(level, log_macro, ...)                                           \
+    do {                                                                        \
+        if ((level) > __log_level) {                                            \
+            break;                                                              \
+        }                                                                       \
+        static uint32_t _rl_next;                                               \
+        static uint32_t _rl_dropped;                                            \
+        const uint32_t _rl_now = k_uptime_get_32();                             \
+                                                                                \
+        if ((int32_t)(_rl_now - _rl_next) >= 0) {                               \
+            _rl_next = _rl_now + CONFIG_APP_LOG_RL_PERIOD_MS;                   \
+            log_macro(__VA_ARGS__);                                             \
+            if (_rl_dropped != 0U) {                                            \
+                log_macro("(%u similar suppressed)", _rl_dropped);              \
+                _rl_dropped = 0U;                                               \
+            }                                                                   \
+        } else {                                                                \
+            _rl_dropped++;                                                      \
+            atomic_inc(&log_rl_dropped);                                        \
+        }                                                                       \
+    } while (0)
+
+#define LOG_RL_ERR(...) LOG_RL(LOG_LEVEL_ERR, LOG_ERR, __VA_ARGS__)
+#define LOG_RL_WRN(...) LOG_RL(LOG_LEVEL_WRN, LOG_WRN, __VA_ARGS__)
+#define LOG_RL_INF(...) LOG_RL(LOG_LEVEL_INF, LOG_INF, __VA_ARGS__)
+#define LOG_RL_DBG(...) LOG_RL(LOG_LEVEL_DBG, LOG_DBG, __VA_ARGS__)
+
+#endif /* APP_LOG_RL_H_ */
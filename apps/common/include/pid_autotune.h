@@ -0,0 +1,119 @@
+/**
+ * @file pid_autotune.h
+ * @brief Relay feedback autotuning of the position loop
+ *
+ * The canard thread validates a request and hands it to the motor thread,
+ * which pauses the application state machine, switches the drive to
+ * speed mode and closes a relay with hysteresis around the start position:
+ * the speed target toggles between +d and -d whenever the position error
+ * leaves the +-h band. The resulting limit cycle gives the ultimate gain
+ * Ku = 4d / (pi * sqrt(a^2 - h^2)) and period Tu of the position plant
+ * (speed loop included), from which Tyreus-Luyben PI gains are derived.
+ *
+ * The experiment is only started while the application is at rest, and
+ * aborts when the excursion from the start position exceeds the requested
+ * limit, the drive state changes (fault, disable) or the timeout expires.
+ * Afterwards the drive is stopped and the previous mode restored.
+ *
+ * Raw service on CONFIG_PID_AUTOTUNE_SERVICE_ID (little endian):
+ *   STATUS  -> result (below), immediately
+ *   START   [1..4] relay amplitude d f32, speed target units
+ *           [5..8] hysteresis h f32, position units
+ *           [9..12] maximum excursion f32, position units
+ *           [13] limit cycles to average, 2..16
+ *           -> result, once the experiment has finished
+ *   ABORT   -> result, immediately
+ * Result: [0] err [1] state [2..5] Ku [6..9] Tu s [10..13] amplitude a
+ *         [14..29] gains f32 in PidParameter order
+ *         [speed_kp, speed_ki, posi_kp, posi_ki]; the speed loop is not
+ *         identified and reported as NaN (PidParameter keeps NaN gains
+ *         unchanged). ki is continuous time, 1/s.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_PID_AUTOTUNE_H_
+#define APP_PID_AUTOTUNE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zephyr/device.h>
+#include <zephyr/sys/util.h>
+
+#define PID_AUTOTUNE_REQUEST_EXTENT 14U
+#define PID_AUTOTUNE_RESULT_SIZE 30U
+
+enum pid_autotune_op {
+    PID_AUTOTUNE_OP_STATUS = 0,
+    PID_AUTOTUNE_OP_START = 1,
+    PID_AUTOTUNE_OP_ABORT = 2,
+};
+
+enum pid_autotune_state {
+    PID_AUTOTUNE_IDLE = 0,
+    PID_AUTOTUNE_REQUESTED,   ///< Waiting for the motor thread to take over
+    PID_AUTOTUNE_SETTLE,      ///< Drive held at zero speed before the relay starts
+    PID_AUTOTUNE_RELAY,       ///< Limit cycle running
+    PID_AUTOTUNE_DONE,        ///< Gains available
+    PID_AUTOTUNE_FAILED,      ///< Aborted, err holds the reason
+};
+
+#if defined(CONFIG_PID_AUTOTUNE)
+
+/**
+ * @brief Validate and queue an experiment (canard thread)
+ * @retval -EBUSY an experiment is already running
+ * @retval -EINVAL parameters outside the configured limits
+ */
+int pid_autotune_start(const uint8_t *req, size_t len);
+
+/** @brief Request an abort (canard thread) */
+void pid_autotune_abort(void);
+
+/** @brief True from start until the drive has been handed back */
+bool pid_autotune_busy(void);
+
+/** @brief True while a started experiment waits for the motor thread */
+bool pid_autotune_requested(void);
+
+/** @brief True once the last experiment has finished or failed */
+bool pid_autotune_finished(void);
+
+/**
+ * @brief Run one step of the experiment (motor thread, every control loop)
+ * @param may_start The application is at rest and can be paused
+ * @return true while the experiment owns the drive, the application
+ *         state machine must not run
+ *
+ * The drive is handed back in its previous mode, holding where the relay
+ * left it (up to the requested excursion from the start position).
+ * Applications that track a nominal position must re-read it afterwards.
+ */
+bool pid_autotune_step(const struct device *motor, bool may_start);
+
+/** @brief Encode the current state and results, PID_AUTOTUNE_RESULT_SIZE bytes */
+size_t pid_autotune_result(uint8_t *buf, int err);
+
+#else
+
+static inline bool pid_autotune_busy(void)
+{
+    return false;
+}
+
+static inline bool pid_autotune_requested(void)
+{
+    return false;
+}
+
+static inline bool pid_autotune_step(const struct device *motor, bool may_start)
+{
+    ARG_UNUSED(motor);
+    ARG_UNUSED(may_start);
+    return false;
+}
+
+#endif /* CONFIG_PID_AUTOTUNE */
+
+#endif /* APP_PID_AUTOTUNE_H_ */
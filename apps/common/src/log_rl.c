@@ -0,0 +1,10 @@
+/**
+ * @file log_rl.c
+ * @brief Counter shared by the rate-limited log sites
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "log_rl.h"
+
+atomic_t log_rl_dropped;
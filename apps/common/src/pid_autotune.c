@@ -0,0 +1,286 @@
+/**
+ * @file pid_autotune.c
+ * @brief Relay feedback autotuning of the position loop
+ *
+ * The request parameters are written by the canard thread while no
+ * experiment is running, the experiment state is owned by the motor
+ * thread, results are written before the state turns DONE/FAILED. The
+ * state variable is the only field both threads access concurrently.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#include <math.h>
+#include <string.h>
+#include <lib/bldcmotor/motor.h>
+#include "pid_autotune.h"
+
+LOG_MODULE_REGISTER(pid_autotune, LOG_LEVEL_INF);
+
+#define AUTOTUNE_SETTLE_MS     200U   //继电器启动前零速保持时间
+#define AUTOTUNE_MIN_CYCLES    2U
+#define AUTOTUNE_MAX_CYCLES    16U
+#define AUTOTUNE_MAX_RELAY     (CONFIG_PID_AUTOTUNE_MAX_RELAY_MILLI / 1000.0f)
+#define AUTOTUNE_MAX_EXCURSION (CONFIG_PID_AUTOTUNE_MAX_EXCURSION_MILLI / 1000.0f)
+
+/* Tyreus-Luyben PI: 比 Ziegler-Nichols 超调小, 适合带负载的顶升 */
+#define TL_KP_DIV 3.2f
+#define TL_TI_MUL 2.2f
+
+static atomic_t state = ATOMIC_INIT(PID_AUTOTUNE_IDLE);
+static atomic_t abort_req;
+
+static struct {
+    /* 请求参数 */
+    float relay;
+    float hyst;
+    float excursion;
+    uint8_t cycles;
+
+    /* 实验状态 */
+    int saved_mode;
+    int saved_state;      //接管时的驱动状态, 变化即视为故障或被禁用
+    float origin;
+    float out;
+    float polarity;       //正速度使位置减小时为 -1, 误差按此取向
+    float e_max;
+    float e_min;
+    uint32_t start_ms;
+    uint32_t last_up;
+    uint8_t switches;
+    uint8_t counted;
+    uint64_t period_sum_us;
+    float amp_sum;
+
+    /* 结果 */
+    int err;
+    float ku;
+    float tu;
+    float amp;
+    float kp;
+    float ki;
+} at;
+
+static bool state_busy(atomic_val_t st)
+{
+    return st == PID_AUTOTUNE_REQUESTED || st == PID_AUTOTUNE_SETTLE || st == PID_AUTOTUNE_RELAY;
+}
+
+bool pid_autotune_busy(void)
+{
+    return state_busy(atomic_get(&state));
+}
+
+bool pid_autotune_requested(void)
+{
+    return atomic_get(&state) == PID_AUTOTUNE_REQUESTED;
+}
+
+bool pid_autotune_finished(void)
+{
+    const atomic_val_t st = atomic_get(&state);
+
+    return st == PID_AUTOTUNE_DONE || st == PID_AUTOTUNE_FAILED;
+}
+
+static float get_float(const uint8_t *p)
+{
+    const uint32_t raw = sys_get_le32(p);
+    float v;
+
+    memcpy(&v, &raw, sizeof(v));
+    return v;
+}
+
+static void put_float(float v, uint8_t *p)
+{
+    uint32_t raw;
+
+    memcpy(&raw, &v, sizeof(raw));
+    sys_put_le32(raw, p);
+}
+
+int pid_autotune_start(const uint8_t *req, size_t len)
+{
+    if (pid_autotune_busy()) {
+        return -EBUSY;
+    }
+    if (len < PID_AUTOTUNE_REQUEST_EXTENT) {
+        return -EINVAL;
+    }
+    const float relay = get_float(&req[1]);
+    const float hyst = get_float(&req[5]);
+    const float excursion = get_float(&req[9]);
+    const uint8_t cycles = req[13];
+
+    // 写成取反形式, NaN 也会被拒绝
+    if (!(relay > 0.0f && relay <= AUTOTUNE_MAX_RELAY) ||
+        !(excursion > 0.0f && excursion <= AUTOTUNE_MAX_EXCURSION) ||
+        !(hyst >= 0.0f && hyst < excursion) ||
+        cycles < AUTOTUNE_MIN_CYCLES || cycles > AUTOTUNE_MAX_CYCLES) {
+        return -EINVAL;
+    }
+    at.relay = relay;
+    at.hyst = hyst;
+    at.excursion = excursion;
+    at.cycles = cycles;
+    atomic_clear(&abort_req);
+    atomic_set(&state, PID_AUTOTUNE_REQUESTED);
+    return 0;
+}
+
+void pid_autotune_abort(void)
+{
+    atomic_set(&abort_req, 1);
+}
+
+static void autotune_finish(const struct device *motor, int err)
+{
+    // 停车并恢复原模式, 位置模式下目标 0 表示原地保持
+    motor_set_target(motor, 0.0f);
+    if (at.saved_mode != MOTOR_MODE_SPEED) {
+        motor_set_mode(motor, at.saved_mode);
+    }
+
+    if (err == 0) {
+        at.amp = at.amp_sum / at.counted;
+        at.tu = (float)at.period_sum_us / at.counted / 1e6f;
+        if (at.amp <= at.hyst || at.tu <= 0.0f) {
+            err = -EDOM;
+        } else {
+            at.ku = 4.0f * at.relay / (3.14159265f * sqrtf(at.amp * at.amp - at.hyst * at.hyst));
+            at.kp = at.ku / TL_KP_DIV;
+            at.ki = at.kp / (TL_TI_MUL * at.tu);
+        }
+    }
+    at.err = err;
+    if (err == 0) {
+        LOG_INF("Ku %d/1000, Tu %d ms -> posi kp %d/1000, ki %d/1000",
+                (int)(at.ku * 1000.0f), (int)(at.tu * 1000.0f),
+                (int)(at.kp * 1000.0f), (int)(at.ki * 1000.0f));
+    } else {
+        LOG_WRN("Autotune failed: %d", err);
+    }
+    atomic_set(&state, err == 0 ? PID_AUTOTUNE_DONE : PID_AUTOTUNE_FAILED);
+}
+
+static void autotune_take_over(const struct device *motor)
+{
+    at.saved_mode = motor_get_mode(motor);
+    at.saved_state = motor_get_state(motor);
+    motor_set_target(motor, 0.0f);
+    if (at.saved_mode != MOTOR_MODE_SPEED) {
+        motor_set_mode(motor, MOTOR_MODE_SPEED);
+    }
+    at.origin = motor_get_curposi(motor);
+    at.start_ms = k_uptime_get_32();
+    at.polarity = 1.0f;
+    at.switches = 0;
+    at.counted = 0;
+    at.period_sum_us = 0;
+    at.amp_sum = 0.0f;
+    at.ku = at.tu = at.amp = at.kp = at.ki = 0.0f;
+    atomic_set(&state, PID_AUTOTUNE_SETTLE);
+}
+
+static void autotune_relay(const struct device *motor, float e, uint32_t now)
+{
+    const float ep = at.polarity * e;
+
+    // 第一个半周期内反向越界说明速度与位置方向相反, 翻转极性后继续
+    if (at.switches == 0U && ep < -at.hyst) {
+        at.polarity = -at.polarity;
+        return;
+    }
+    at.e_max = MAX(at.e_max, ep);
+    at.e_min = MIN(at.e_min, ep);
+
+    if (at.out > 0.0f && ep > at.hyst) {
+        at.out = -at.relay;
+    } else if (at.out < 0.0f && ep < -at.hyst) {
+        at.out = at.relay;
+        // 以向上切换为周期起点, 第一个完整周期之前属于过渡过程
+        if (at.switches >= 3U) {
+            at.period_sum_us += k_cyc_to_us_floor32(now - at.last_up);
+            at.amp_sum += (at.e_max - at.e_min) / 2.0f;
+            at.counted++;
+        }
+        at.last_up = now;
+        at.e_max = ep;
+        at.e_min = ep;
+    } else {
+        return;
+    }
+    at.switches = MIN(at.switches + 1U, UINT8_MAX);
+    motor_set_target(motor, at.out);
+    if (at.counted >= at.cycles) {
+        autotune_finish(motor, 0);
+    }
+}
+
+bool pid_autotune_step(const struct device *motor, bool may_start)
+{
+    const atomic_val_t st = atomic_get(&state);
+    const uint32_t now = k_cycle_get_32();
+
+    if (st == PID_AUTOTUNE_REQUESTED) {
+        if (!may_start) {
+            at.err = -EAGAIN;
+            atomic_set(&state, PID_AUTOTUNE_FAILED);
+            return false;
+        }
+        autotune_take_over(motor);
+        return true;
+    }
+    if (st != PID_AUTOTUNE_SETTLE && st != PID_AUTOTUNE_RELAY) {
+        return false;
+    }
+
+    const uint32_t elapsed_ms = k_uptime_get_32() - at.start_ms;
+    const float e = motor_get_curposi(motor) - at.origin;
+
+    if (atomic_get(&abort_req) != 0) {
+        autotune_finish(motor, -ECANCELED);
+    } else if (elapsed_ms > CONFIG_PID_AUTOTUNE_TIMEOUT_MS) {
+        autotune_finish(motor, -ETIMEDOUT);
+    } else if (motor_get_state(motor) != at.saved_state) {
+        autotune_finish(motor, -EIO);
+    } else if (fabsf(e) > at.excursion) {
+        autotune_finish(motor, -ERANGE);
+    } else if (st == PID_AUTOTUNE_SETTLE) {
+        if (elapsed_ms >= AUTOTUNE_SETTLE_MS) {
+            at.origin += e;
+            at.out = at.relay;
+            at.e_max = 0.0f;
+            at.e_min = 0.0f;
+            motor_set_target(motor, at.out);
+            atomic_set(&state, PID_AUTOTUNE_RELAY);
+        }
+    } else {
+        autotune_relay(motor, e, now);
+    }
+    return true;
+}
+
+size_t pid_autotune_result(uint8_t *buf, int err)
+{
+    const atomic_val_t st = atomic_get(&state);
+    const bool done = (st == PID_AUTOTUNE_DONE);
+
+    if (err == 0 && st == PID_AUTOTUNE_FAILED) {
+        err = at.err;
+    }
+    buf[0] = (uint8_t)(-err);
+    buf[1] = (uint8_t)st;
+    put_float(done ? at.ku : 0.0f, &buf[2]);
+    put_float(done ? at.tu : 0.0f, &buf[6]);
+    put_float(done ? at.amp : 0.0f, &buf[10]);
+    put_float(NAN, &buf[14]);
+    put_float(NAN, &buf[18]);
+    put_float(done ? at.kp : NAN, &buf[22]);
+    put_float(done ? at.ki : NAN, &buf[26]);
+    return PID_AUTOTUNE_RESULT_SIZE;
+}
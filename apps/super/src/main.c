@@ -13,19 +13,31 @@
  #include <zephyr/drivers/can.h>
  #include <lib/foc/foc.h>
  
+ #include "canard_blackbox.h"
+ 
  LOG_MODULE_REGISTER(main, LOG_LEVEL_DBG);
  
  /* 1000 msec = 1 sec */
  #define SLEEP_TIME_MS   1
  
  extern void creat_motor_thread(const struct device *dev);
- extern void creat_canard_thread(void* p1);
+ extern void creat_canard_thread(void);
  
  int main(void)
  {
-    const struct device *motor0 = DEVICE_DT_GET(DT_NODELABEL(motor0));
-     creat_canard_thread((void *)motor0); 
+     /*
+      * Create both threads before either runs. CAN bring-up goes first
+      * (higher priority) so the first heartbeat is not held back, motor
+      * bring-up runs whenever the canard thread waits.
+      */
+#if defined(CONFIG_CANARD_BLACKBOX)
+     /* 在任何线程与 CAN 中断开始记录之前校验环形缓冲 */
+     canard_blackbox_init();
+#endif
+     k_sched_lock();
+     creat_canard_thread(); 
      creat_motor_thread(NULL);
+     k_sched_unlock();
      while (1) {
          k_msleep(1000);
      }
@@ -18,11 +18,21 @@
  #include <zephyr/drivers/gpio.h>
  #include <zephyr/logging/log.h>
  #include <lib/bldcmotor/motor.h>
+ #include "pid_autotune.h"
+ #include "elevator_if.h"
+ #include "hot_path.h"
+ #include "canard_telemetry.h"
+ #include "canard_scope.h"
+ #include "canard_blackbox.h"
+ #include "log_rl.h"
  /* Module logging setup */
  LOG_MODULE_REGISTER(motor_thread, LOG_LEVEL_DBG);
  
  /* Thread stack definition */
- K_THREAD_STACK_DEFINE(motor_thread_stack, 2048);
+ /* 驱动调用与 FPU_SHARING 下的浮点上下文, 只拦住明显不够的配置 */
+ BUILD_ASSERT(CONFIG_APP_MOTOR_THREAD_STACK_SIZE >= 1024U,
+              "CONFIG_APP_MOTOR_THREAD_STACK_SIZE too small for the motor loop");
+ K_THREAD_STACK_DEFINE(motor_thread_stack, CONFIG_APP_MOTOR_THREAD_STACK_SIZE);
  
  /* Device tree node aliases */
  #define LED0_NODE DT_ALIAS(led0)
@@ -30,11 +40,26 @@
  #define ENCODER_VCC DT_NODELABEL(encoder_vcc)
  #define W_DOG DT_NODELABEL(wdog)
  #define P_SWITCH DT_NODELABEL(proximity_switch)
+ #define ENCODER_SETTLE_MS 10   /* Encoder output valid after power-on */
  /* GPIO device specification */
  const struct gpio_dt_spec led = GPIO_DT_SPEC_GET(LED0_NODE, gpios);
  
+ #if defined(CONFIG_APP_CYCLE_STATS)
+ /* 每个控制周期的耗时, 由 canard 线程定期输出 */
+ struct cycle_stats motor_loop_cycles;
+ #endif
+ 
  /* External motor control function */
  void wheelmotor_task(void* obj);
+ #if defined(CONFIG_APP_PID_APPLY)
+ extern bool canard_if_pid_due(const float **params);
+ /* lib/bldcmotor: 换入 [speed_kp, speed_ki, posi_kp, posi_ki], NaN 项不改, 无扰切换 */
+ extern int motor_pid_apply(const struct device *motor, const float *params);
+ #endif
+ #if defined(CONFIG_CANARD_SCOPE)
+ static float scope_wheel_target(const struct device *motor);
+ #endif
+ extern bool canard_if_setpoint_due(float *target);
  extern fsm_rt_t motor_torque_control_mode(fsm_cb_t *obj);
  extern fsm_rt_t motor_speed_control_mode(fsm_cb_t *obj);
  extern fsm_rt_t motor_position_control_mode(fsm_cb_t *obj);
@@ -62,13 +87,20 @@
  static void super_thread_entry(void *p1, void *p2, void *p3)
  {
  #if defined(CONFIG_BOARD_ZGM_002)
+     /* Power the encoder first, it settles while the other pins are set up */
+     const struct gpio_dt_spec encoder_vcc = GPIO_DT_SPEC_GET(ENCODER_VCC, gpios);
+     int ret = gpio_pin_configure_dt(&encoder_vcc, GPIO_OUTPUT_ACTIVE);
+     const int64_t encoder_on_ms = k_uptime_get();
+     if (ret < 0) {
+         LOG_ERR("Failed to configure encoder power (err %d)", ret);
+     }
+
      /* Initialize LED indicator */
      if (!device_is_ready(led.port)) {
          LOG_ERR("LED device not ready");
          return;
      }
-     k_msleep(1000);
-     int ret = gpio_pin_configure_dt(&led, GPIO_OUTPUT_ACTIVE);
+     ret = gpio_pin_configure_dt(&led, GPIO_OUTPUT_ACTIVE);
      if (ret < 0) {
          LOG_ERR("Failed to configure LED (err %d)", ret);
      }
@@ -87,20 +119,22 @@
          LOG_ERR("Failed to configure watchdog pin (err %d)", ret);
      }
  
-     /* Initialize encoder power */
-     const struct gpio_dt_spec encoder_vcc = GPIO_DT_SPEC_GET(ENCODER_VCC, gpios);
-     ret = gpio_pin_configure_dt(&encoder_vcc, GPIO_OUTPUT_ACTIVE);
-     if (ret < 0) {
-         LOG_ERR("Failed to configure encoder power (err %d)", ret);
-     }
-
           
  #endif
  
-     /* Initial delay for hardware stabilization */
-     k_msleep(10);
- 
      const struct device *motor0 = DEVICE_DT_GET(DT_NODELABEL(motor0));
+     if (!device_is_ready(motor0)) {
+         LOG_ERR("Motor device not ready");
+         return;
+     }
+ #if defined(CONFIG_CANARD_SCOPE)
+     /* 示波器应用变量: 最近一次生效的目标值 */
+     canard_scope_register(CANARD_SCOPE_VAR_APP + 0, scope_wheel_target);
+ #endif
+ #if defined(CONFIG_BOARD_ZGM_002)
+     /* Remaining encoder settle time, counted from power-on */
+     k_sleep(K_TIMEOUT_ABS_MS(encoder_on_ms + ENCODER_SETTLE_MS));
+ #endif
      
      /* Main control loop */
      while (1) {
@@ -109,7 +143,19 @@
         gpio_pin_toggle_dt(&w_dog);
  #endif
         /* Run motor control tasks */
+ #if defined(CONFIG_APP_CYCLE_STATS)
+        const uint32_t start = k_cycle_get_32();
+ #endif
         wheelmotor_task((void *)motor0);
+ #if defined(CONFIG_CANARD_TELEMETRY)
+        canard_telemetry_sample(motor0);
+ #endif
+ #if defined(CONFIG_CANARD_SCOPE)
+        canard_scope_sample(motor0);
+ #endif
+ #if defined(CONFIG_APP_CYCLE_STATS)
+        cycle_stats_add(&motor_loop_cycles, start);
+ #endif
         k_msleep(1);
      }
  }
@@ -145,7 +191,17 @@ enum{
     WHEELMOTOR_INIT = USER_STATUS,
     WHEELMOTOR_IDLE,
 };
-void wheelmotor_task(void* obj)
+#if defined(CONFIG_CANARD_SCOPE)
+static float applied_target;
+
+static float scope_wheel_target(const struct device *motor)
+{
+    ARG_UNUSED(motor);
+    return applied_target;
+}
+#endif
+
+APP_HOT_TEXT void wheelmotor_task(void* obj)
 {
     fsm_cb_t* elevator_fsm = &wheelmotor_handle;
 
@@ -154,8 +210,30 @@ void wheelmotor_task(void* obj)
     const struct motor_config *cfg = motor->config;
     data = motor->data;
 
+#if defined(CONFIG_APP_PID_APPLY)
+    /* Swap in PID parameters staged by canard_thread */
+    const float *pid;
+    if (canard_if_pid_due(&pid) && motor_pid_apply(motor, pid) < 0) {
+        LOG_WRN("PID parameters not applied");
+    }
+#endif
+
+    /* Apply setpoints whose bus-time deadline has passed */
+    float target;
+    //自整定期间设定值照常出队, 但不生效
+    if (canard_if_setpoint_due(&target) && !pid_autotune_busy()) {
+        motor_set_target(motor, target);
+#if defined(CONFIG_CANARD_SCOPE)
+        applied_target = target;
+        canard_scope_command_event();   //以生效时刻而非接收时刻作为触发点
+#endif
+    }
+
     /* Run state machine */
     DISPATCH_FSM(cfg->fsm);
+    if (pid_autotune_step(motor, elevator_fsm->chState == WHEELMOTOR_IDLE)) {
+        return;
+    }
     elevator_fsm->p1 = (void *)motor;
     switch (elevator_fsm->chState) {
         case ENTER:
@@ -180,6 +258,9 @@ void wheelmotor_task(void* obj)
        case EXIT:
             break;
     }
+#if defined(CONFIG_CANARD_BLACKBOX)
+    canard_blackbox_track(motor, elevator_fsm->chState);
+#endif
 }
 /**
 uint8 INIT = 0
@@ -0,0 +1,59 @@
+/**
+ * @file elevator.h
+ * @brief Elevator internals shared by the motor thread modules
+ *
+ * The canard-facing part lives in elevator_if.h.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef APP_ELEVATOR_H_
+#define APP_ELEVATOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "elevator_if.h"
+
+/**
+ * @brief Load the flash copy of the homing reference (motor thread, once)
+ */
+void elevator_persist_init(void);
+
+/**
+ * @brief Fetch the persisted rest height if a valid reference exists
+ * @retval 0 @p height filled from retained RAM or flash
+ * @retval -ENOENT no valid reference, full homing required
+ */
+int elevator_persist_restore(float *height);
+
+/** @brief Record that the lift is homed and resting at @p height */
+void elevator_persist_save(float height);
+
+/**
+ * @brief Mark the reference invalid, called before any motion
+ *
+ * The RAM copy is invalidated at once, the flash copy by the system
+ * work queue. Keep calling until it returns true before starting the
+ * drive, so a power loss in motion never restores a stale height.
+ *
+ * @retval true no valid reference survives a reset, motion may start
+ * @retval false the invalidating flash write is still pending
+ */
+bool elevator_persist_invalidate(void);
+
+/** @brief Update the local status broadcast to the group (motor thread) */
+void elevator_group_set_self(int8_t state, float height, bool moving, bool up);
+
+/** @brief True while at least one other member of the group is known */
+bool elevator_group_active(void);
+
+/**
+ * @brief Furthest height the local node may command in direction @p up
+ * @param current Height commanded so far, the limit never falls behind it
+ * @param limit Set to the leader reference, or to @p current while the
+ *        reference is missing or stale
+ * @return True if the leader reference is fresh
+ */
+bool elevator_group_limit(bool up, float current, float *limit);
+
+#endif /* APP_ELEVATOR_H_ */
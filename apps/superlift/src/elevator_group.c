@@ -0,0 +1,262 @@
+/**
+ * @file elevator_group.c
+ * @brief Coordinated lift groups
+ *
+ * Every node of a group broadcasts a 7-byte status frame on
+ * CONFIG_ELEVATOR_GROUP_PORT_ID. The live member with the lowest node ID
+ * acts as leader: it derives a height reference from the slowest moving
+ * member and broadcasts it for as long as any member, itself included or
+ * not, is still moving. Each node runs a single position move per command
+ * and keeps pulling its target along behind that reference, so the group
+ * travels at full speed yet stays within CONFIG_ELEVATOR_GROUP_TOLERANCE
+ * of each other.
+ *
+ * Status frame (little endian):
+ *   [0]    group ID
+ *   [1]    flags, see GROUP_FLAG_*
+ *   [2]    super_elevator_state()
+ *   [3..4] height x10, int16
+ *   [5..6] leader reference x10, int16, valid with GROUP_FLAG_REF
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+#include "elevator.h"
+
+LOG_MODULE_REGISTER(elevator_group, LOG_LEVEL_INF);
+
+#define GROUP_FLAG_MOVING BIT(0)
+#define GROUP_FLAG_UP     BIT(1)
+#define GROUP_FLAG_REF    BIT(2)
+
+#define GROUP_IDLE_PERIOD_MS 100
+#define GROUP_STALE_MS       200   //超过该时间未收到视为掉线, 高度冻结在最后值
+#define GROUP_DROP_MS        2000  //超过该时间从组内移除
+
+/**
+ * @struct group_member
+ * @brief Last status heard from another node of the group
+ */
+struct group_member {
+    uint8_t node_id;   ///< 0 表示空槽
+    uint8_t flags;
+    int8_t state;
+    float height;
+    int64_t last_seen;
+};
+
+static struct group_member members[CONFIG_ELEVATOR_GROUP_MAX_NODES];
+static struct k_spinlock group_lock;
+static uint8_t self_id;
+
+/* 本节点状态, 由电机线程更新 */
+static struct {
+    uint8_t flags;
+    int8_t state;
+    float height;
+} self;
+
+/* 领队下发的参考高度 */
+static float leader_ref;
+static int64_t leader_ref_time;
+static bool leader_ref_valid;
+
+static int16_t group_height_encode(float h)
+{
+    return (int16_t)CLAMP(h * 10.0f, -32768.0f, 32767.0f);
+}
+
+static float group_height_decode(const uint8_t *p)
+{
+    return (float)(int16_t)sys_get_le16(p) / 10.0f;
+}
+
+/* 调用者需持有 group_lock */
+static void group_expire(int64_t now)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(members); i++) {
+        if (members[i].node_id != 0 && now - members[i].last_seen > GROUP_DROP_MS) {
+            LOG_WRN("Group member %u lost", members[i].node_id);
+            members[i].node_id = 0;
+        }
+    }
+}
+
+/* 调用者需持有 group_lock */
+static bool group_is_leader(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(members); i++) {
+        if (members[i].node_id != 0 && members[i].node_id < self_id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* 组内(含本节点)有成员在运动时返回 true, 并给出其运动方向. 调用者需持有 group_lock */
+static bool group_any_moving(bool *up)
+{
+    if (self.flags & GROUP_FLAG_MOVING) {
+        *up = (self.flags & GROUP_FLAG_UP) != 0;
+        return true;
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(members); i++) {
+        if (members[i].node_id != 0 && (members[i].flags & GROUP_FLAG_MOVING)) {
+            *up = (members[i].flags & GROUP_FLAG_UP) != 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * 领队计算参考高度: 向上时取运动成员的最低高度 + 容差, 向下时取最高高度 - 容差.
+ * 领队自身未收到命令或已先到位时照样下发, 直到所有成员都停下.
+ * 掉线但尚未移除的成员按最后高度参与计算, 组内其他节点因此停在原地等待.
+ * 调用者需持有 group_lock.
+ */
+static bool group_compute_ref(float *ref)
+{
+    bool up;
+
+    if (!group_any_moving(&up)) {
+        return false;
+    }
+    float edge = up ? ELEVATOR_HEIGHT_MAX : 0.0f;
+
+    if ((self.flags & GROUP_FLAG_MOVING) && ((self.flags & GROUP_FLAG_UP) != 0) == up) {
+        edge = self.height;
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(members); i++) {
+        const struct group_member *m = &members[i];
+        if (m->node_id == 0 || !(m->flags & GROUP_FLAG_MOVING) ||
+            ((m->flags & GROUP_FLAG_UP) != 0) != up) {
+            continue;
+        }
+        edge = up ? MIN(edge, m->height) : MAX(edge, m->height);
+    }
+    *ref = up ? edge + CONFIG_ELEVATOR_GROUP_TOLERANCE : edge - CONFIG_ELEVATOR_GROUP_TOLERANCE;
+    return true;
+}
+
+void elevator_group_init(uint8_t node_id)
+{
+    self_id = node_id;
+}
+
+void elevator_group_set_self(int8_t state, float height, bool moving, bool up)
+{
+    k_spinlock_key_t key = k_spin_lock(&group_lock);
+
+    self.state = state;
+    self.height = height;
+    self.flags = (moving ? GROUP_FLAG_MOVING : 0) | (up ? GROUP_FLAG_UP : 0);
+    k_spin_unlock(&group_lock, key);
+}
+
+size_t elevator_group_encode(uint8_t *buf, size_t size)
+{
+    if (size < ELEVATOR_GROUP_STATUS_SIZE) {
+        return 0;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&group_lock);
+    uint8_t flags = self.flags;
+    float ref = 0.0f;
+
+    group_expire(k_uptime_get());
+    if (group_is_leader() && group_compute_ref(&ref)) {
+        flags |= GROUP_FLAG_REF;
+        leader_ref = ref;
+        leader_ref_time = k_uptime_get();
+        leader_ref_valid = true;
+    }
+    buf[0] = CONFIG_ELEVATOR_GROUP_ID;
+    buf[1] = flags;
+    buf[2] = (uint8_t)self.state;
+    sys_put_le16((uint16_t)group_height_encode(self.height), &buf[3]);
+    sys_put_le16((uint16_t)group_height_encode(ref), &buf[5]);
+    k_spin_unlock(&group_lock, key);
+
+    return ELEVATOR_GROUP_STATUS_SIZE;
+}
+
+void elevator_group_decode(uint8_t src, const uint8_t *buf, size_t len)
+{
+    if (len < ELEVATOR_GROUP_STATUS_SIZE || buf[0] != CONFIG_ELEVATOR_GROUP_ID ||
+        src == self_id || src == 0) {
+        return;
+    }
+
+    const int64_t now = k_uptime_get();
+    k_spinlock_key_t key = k_spin_lock(&group_lock);
+    struct group_member *slot = NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(members); i++) {
+        if (members[i].node_id == src) {
+            slot = &members[i];
+            break;
+        }
+        if (slot == NULL && members[i].node_id == 0) {
+            slot = &members[i];
+        }
+    }
+    if (slot != NULL) {
+        slot->node_id = src;
+        slot->flags = buf[1];
+        slot->state = (int8_t)buf[2];
+        slot->height = group_height_decode(&buf[3]);
+        slot->last_seen = now;
+    }
+    if ((buf[1] & GROUP_FLAG_REF) && !group_is_leader()) {
+        leader_ref = group_height_decode(&buf[5]);
+        leader_ref_time = now;
+        leader_ref_valid = true;
+    }
+    k_spin_unlock(&group_lock, key);
+}
+
+bool elevator_group_active(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&group_lock);
+    bool active = false;
+
+    for (size_t i = 0; i < ARRAY_SIZE(members); i++) {
+        if (members[i].node_id != 0) {
+            active = true;
+            break;
+        }
+    }
+    k_spin_unlock(&group_lock, key);
+    return active;
+}
+
+bool elevator_group_limit(bool up, float current, float *limit)
+{
+    k_spinlock_key_t key = k_spin_lock(&group_lock);
+    float ref = current;
+    /* 参考过期(领队掉线或尚未收到本节点的运动状态)时原地等待 */
+    const bool fresh = leader_ref_valid && k_uptime_get() - leader_ref_time <= GROUP_STALE_MS;
+
+    if (fresh) {
+        ref = leader_ref;
+    }
+    k_spin_unlock(&group_lock, key);
+
+    *limit = up ? MAX(ref, current) : MIN(ref, current);
+    return fresh;
+}
+
+uint32_t elevator_group_period_ms(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&group_lock);
+    bool up;
+    /* 领队在其他成员运动期间也要按运动周期下发参考 */
+    const bool moving = group_any_moving(&up);
+
+    k_spin_unlock(&group_lock, key);
+    return moving ? CONFIG_ELEVATOR_GROUP_PERIOD_MS : GROUP_IDLE_PERIOD_MS;
+}
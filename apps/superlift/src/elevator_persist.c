@@ -0,0 +1,201 @@
+/**
+ * @file elevator_persist.c
+ * @brief Homing reference kept across resets
+ *
+ * The last validated lift height is mirrored into a no-init RAM block that
+ * survives watchdog/software resets, and into flash through the settings
+ * subsystem for power cycles. Both copies carry a magic and CRC32; the
+ * record is invalidated before every move so a reset in motion always
+ * falls back to a full homing run. A move only starts once the flash
+ * copy is known to be invalid, i.e. after the invalidating write has
+ * completed. The valid record is written a while after the lift comes
+ * to rest, so back-to-back moves do not touch the flash in between.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/logging/log.h>
+#if defined(CONFIG_ELEVATOR_HOMING_PERSIST_FLASH)
+#include <zephyr/settings/settings.h>
+#endif
+#include "elevator.h"
+
+LOG_MODULE_REGISTER(elevator_persist, LOG_LEVEL_INF);
+
+#define ELEVATOR_REF_MAGIC 0x454C5631U  /* "ELV1" */
+
+/**
+ * @struct elevator_ref
+ * @brief Persisted homing reference
+ */
+struct elevator_ref {
+    uint32_t magic;
+    uint32_t homed;   ///< 1: 已回零且静止, height 可信
+    float height;     ///< 静止时的名义高度
+    uint32_t crc;     ///< 以上字段的 CRC32
+};
+
+/* 复位后不清零的 RAM 副本 */
+static struct elevator_ref retained_ref __noinit;
+
+static uint32_t elevator_ref_crc(const struct elevator_ref *ref)
+{
+    return crc32_ieee((const uint8_t *)ref, offsetof(struct elevator_ref, crc));
+}
+
+static bool elevator_ref_valid(const struct elevator_ref *ref)
+{
+    return ref->magic == ELEVATOR_REF_MAGIC &&
+           ref->crc == elevator_ref_crc(ref) &&
+           ref->homed == 1U &&
+           ref->height >= 0.0f && ref->height <= ELEVATOR_HEIGHT_MAX;
+}
+
+static void elevator_ref_fill(struct elevator_ref *ref, bool homed, float height)
+{
+    ref->magic = ELEVATOR_REF_MAGIC;
+    ref->homed = homed ? 1U : 0U;
+    ref->height = homed ? height : 0.0f;
+    ref->crc = elevator_ref_crc(ref);
+}
+
+#if defined(CONFIG_ELEVATOR_HOMING_PERSIST_FLASH)
+/* settings 中加载到的副本 */
+static struct elevator_ref flash_ref;
+/* 待写入 flash 的副本, 由电机线程更新, 工作队列写入 */
+static struct elevator_ref pending_ref;
+/* 最近一次成功写入 flash 的副本, 仅工作队列访问 */
+static struct elevator_ref stored_ref;
+static struct k_spinlock pending_lock;
+/* 1: flash 中的记录无效且没有待写的有效记录, 可以开始移动 */
+static atomic_t flash_invalid;
+
+#define ELEVATOR_REF_RETRY_MS 1000
+
+static int elevator_ref_set(const char *name, size_t len,
+                            settings_read_cb read_cb, void *cb_arg)
+{
+    const char *next;
+
+    if (settings_name_steq(name, "ref", &next) && next == NULL) {
+        if (len != sizeof(flash_ref)) {
+            return -EINVAL;
+        }
+        ssize_t rc = read_cb(cb_arg, &flash_ref, sizeof(flash_ref));
+        return rc < 0 ? (int)rc : 0;
+    }
+    return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(elevator, "elev", NULL, elevator_ref_set, NULL, NULL);
+
+/* flash 擦写可能耗时数百毫秒, 不能放在 1ms 控制循环里 */
+static void elevator_ref_store(struct k_work *work)
+{
+    struct elevator_ref ref;
+    k_spinlock_key_t key = k_spin_lock(&pending_lock);
+
+    ref = pending_ref;
+    k_spin_unlock(&pending_lock, key);
+
+    if (memcmp(&ref, &stored_ref, sizeof(ref)) != 0) {
+        int ret = settings_save_one("elev/ref", &ref, sizeof(ref));
+        if (ret < 0) {
+            //写入失败时 flash 内容未知, 移动继续等待, 稍后重试
+            LOG_ERR("Failed to store homing reference (err %d)", ret);
+            k_work_schedule(k_work_delayable_from_work(work), K_MSEC(ELEVATOR_REF_RETRY_MS));
+            return;
+        }
+        stored_ref = ref;
+    }
+
+    key = k_spin_lock(&pending_lock);
+    if (pending_ref.homed == 0U && stored_ref.homed == 0U) {
+        atomic_set(&flash_invalid, 1);
+    }
+    k_spin_unlock(&pending_lock, key);
+}
+
+static K_WORK_DELAYABLE_DEFINE(elevator_ref_work, elevator_ref_store);
+#endif
+
+void elevator_persist_init(void)
+{
+#if defined(CONFIG_ELEVATOR_HOMING_PERSIST_FLASH)
+    int ret = settings_subsys_init();
+    if (ret == 0) {
+        ret = settings_load_subtree("elev");
+    }
+    if (ret < 0) {
+        LOG_WRN("Settings unavailable (err %d)", ret);
+    }
+    stored_ref = flash_ref;
+    pending_ref = flash_ref;
+    atomic_set(&flash_invalid, elevator_ref_valid(&flash_ref) ? 0 : 1);
+#endif
+}
+
+int elevator_persist_restore(float *height)
+{
+    if (elevator_ref_valid(&retained_ref)) {
+        *height = retained_ref.height;
+        LOG_INF("Homing reference restored from RAM: %d", (int)*height);
+        return 0;
+    }
+#if defined(CONFIG_ELEVATOR_HOMING_PERSIST_FLASH)
+    if (elevator_ref_valid(&flash_ref)) {
+        *height = flash_ref.height;
+        retained_ref = flash_ref;
+        LOG_INF("Homing reference restored from flash: %d", (int)*height);
+        return 0;
+    }
+#endif
+    return -ENOENT;
+}
+
+void elevator_persist_save(float height)
+{
+    elevator_ref_fill(&retained_ref, true, height);
+#if defined(CONFIG_ELEVATOR_HOMING_PERSIST_FLASH)
+    k_spinlock_key_t key = k_spin_lock(&pending_lock);
+
+    pending_ref = retained_ref;
+    atomic_clear(&flash_invalid);
+    k_spin_unlock(&pending_lock, key);
+    //静止一段时间后再写, 紧接着的下一次移动无需擦写 flash
+    k_work_reschedule(&elevator_ref_work, K_MSEC(CONFIG_ELEVATOR_HOMING_PERSIST_FLASH_DELAY_MS));
+#endif
+}
+
+bool elevator_persist_invalidate(void)
+{
+    /* RAM 副本立即作废 */
+    if (retained_ref.magic != ELEVATOR_REF_MAGIC || retained_ref.homed != 0U ||
+        retained_ref.crc != elevator_ref_crc(&retained_ref)) {
+        elevator_ref_fill(&retained_ref, false, 0.0f);
+    }
+#if defined(CONFIG_ELEVATOR_HOMING_PERSIST_FLASH)
+    if (atomic_get(&flash_invalid) != 0) {
+        return true;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&pending_lock);
+    const bool was_homed = pending_ref.homed != 0U;
+
+    pending_ref = retained_ref;
+    k_spin_unlock(&pending_lock, key);
+    if (was_homed) {
+        //取代尚未写入的有效记录
+        k_work_reschedule(&elevator_ref_work, K_NO_WAIT);
+    } else {
+        //已在写入或等待重试, 不打断
+        k_work_schedule(&elevator_ref_work, K_NO_WAIT);
+    }
+    return false;
+#else
+    return true;
+#endif
+}
@@ -13,6 +13,8 @@
  #include <zephyr/drivers/can.h>
  #include <lib/foc/foc.h>
  
+ #include "canard_blackbox.h"
+ 
  LOG_MODULE_REGISTER(main, LOG_LEVEL_DBG);
  
  /* 1000 msec = 1 sec */
@@ -23,8 +25,19 @@
  
  int main(void)
  {
+     /*
+      * Create both threads before either runs. CAN bring-up goes first
+      * (higher priority) so the first heartbeat is not held back, motor
+      * bring-up runs whenever the canard thread waits.
+      */
+#if defined(CONFIG_CANARD_BLACKBOX)
+     /* 在任何线程与 CAN 中断开始记录之前校验环形缓冲 */
+     canard_blackbox_init();
+#endif
+     k_sched_lock();
      creat_canard_thread(); 
      creat_motor_thread(NULL);
+     k_sched_unlock();
      while (1) {
          k_msleep(1000);
      }
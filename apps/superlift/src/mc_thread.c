@@ -18,11 +18,22 @@
  #include <zephyr/drivers/gpio.h>
  #include <zephyr/logging/log.h>
  #include <lib/bldcmotor/motor.h>
+ #include <zephyr/sys/spsc_lockfree.h>
+ #include "elevator.h"
+ #include "pid_autotune.h"
+ #include "hot_path.h"
+ #include "canard_telemetry.h"
+ #include "canard_scope.h"
+ #include "canard_blackbox.h"
+ #include "log_rl.h"
  /* Module logging setup */
  LOG_MODULE_REGISTER(motor_thread, LOG_LEVEL_DBG);
  
  /* Thread stack definition */
- K_THREAD_STACK_DEFINE(motor_thread_stack, 2048);
+ /* 驱动调用与 FPU_SHARING 下的浮点上下文, 只拦住明显不够的配置 */
+ BUILD_ASSERT(CONFIG_APP_MOTOR_THREAD_STACK_SIZE >= 1024U,
+              "CONFIG_APP_MOTOR_THREAD_STACK_SIZE too small for the motor loop");
+ K_THREAD_STACK_DEFINE(motor_thread_stack, CONFIG_APP_MOTOR_THREAD_STACK_SIZE);
  
  /* Device tree node aliases */
  #define LED0_NODE DT_ALIAS(led0)
@@ -30,11 +41,25 @@
  #define ENCODER_VCC DT_NODELABEL(encoder_vcc)
  #define W_DOG DT_NODELABEL(wdog)
  #define P_SWITCH DT_NODELABEL(proximity_switch)
+ #define ENCODER_SETTLE_MS 10   /* Encoder output valid after power-on */
  /* GPIO device specification */
  const struct gpio_dt_spec led = GPIO_DT_SPEC_GET(LED0_NODE, gpios);
  
+ #if defined(CONFIG_APP_CYCLE_STATS)
+ /* 每个控制周期的耗时, 由 canard 线程定期输出 */
+ struct cycle_stats motor_loop_cycles;
+ #endif
+ 
  /* External motor control function */
  void super_elevator_task(void* obj);
+ #if defined(CONFIG_APP_PID_APPLY)
+ extern bool canard_if_pid_due(const float **params);
+ /* lib/bldcmotor: 换入 [speed_kp, speed_ki, posi_kp, posi_ki], NaN 项不改, 无扰切换 */
+ extern int motor_pid_apply(const struct device *motor, const float *params);
+ #endif
+ #if defined(CONFIG_CANARD_SCOPE)
+ static void elevator_scope_register(void);
+ #endif
  extern fsm_rt_t motor_torque_control_mode(fsm_cb_t *obj);
  extern fsm_rt_t motor_speed_control_mode(fsm_cb_t *obj);
  extern fsm_rt_t motor_position_control_mode(fsm_cb_t *obj);
@@ -62,13 +87,20 @@
  static void super_thread_entry(void *p1, void *p2, void *p3)
  {
  #if defined(CONFIG_BOARD_ZGM_002)
+     /* Power the encoder first, it settles while the other pins are set up */
+     const struct gpio_dt_spec encoder_vcc = GPIO_DT_SPEC_GET(ENCODER_VCC, gpios);
+     int ret = gpio_pin_configure_dt(&encoder_vcc, GPIO_OUTPUT_ACTIVE);
+     const int64_t encoder_on_ms = k_uptime_get();
+     if (ret < 0) {
+         LOG_ERR("Failed to configure encoder power (err %d)", ret);
+     }
+
      /* Initialize LED indicator */
      if (!device_is_ready(led.port)) {
          LOG_ERR("LED device not ready");
          return;
      }
-     k_msleep(1000);
-     int ret = gpio_pin_configure_dt(&led, GPIO_OUTPUT_ACTIVE);
+     ret = gpio_pin_configure_dt(&led, GPIO_OUTPUT_ACTIVE);
      if (ret < 0) {
          LOG_ERR("Failed to configure LED (err %d)", ret);
      }
@@ -87,13 +119,6 @@
          LOG_ERR("Failed to configure watchdog pin (err %d)", ret);
      }
  
-     /* Initialize encoder power */
-     const struct gpio_dt_spec encoder_vcc = GPIO_DT_SPEC_GET(ENCODER_VCC, gpios);
-     ret = gpio_pin_configure_dt(&encoder_vcc, GPIO_OUTPUT_ACTIVE);
-     if (ret < 0) {
-         LOG_ERR("Failed to configure encoder power (err %d)", ret);
-     }
-
      const struct gpio_dt_spec prx_switch = GPIO_DT_SPEC_GET(P_SWITCH, gpios);
      ret = gpio_pin_configure_dt(&prx_switch, GPIO_INPUT);
      if (ret < 0) {
@@ -104,10 +129,23 @@
           
  #endif
  
-     /* Initial delay for hardware stabilization */
-     k_msleep(10);
- 
      const struct device *motor0 = DEVICE_DT_GET(DT_NODELABEL(motor0));
+     if (!device_is_ready(motor0)) {
+         LOG_ERR("Motor device not ready");
+         return;
+     }
+
+ #if defined(CONFIG_ELEVATOR_HOMING_PERSIST)
+     /* Load persisted homing reference before the FSM starts */
+     elevator_persist_init();
+ #endif
+ #if defined(CONFIG_CANARD_SCOPE)
+     elevator_scope_register();
+ #endif
+ #if defined(CONFIG_BOARD_ZGM_002)
+     /* Remaining encoder settle time, counted from power-on */
+     k_sleep(K_TIMEOUT_ABS_MS(encoder_on_ms + ENCODER_SETTLE_MS));
+ #endif
      
      /* Main control loop */
      while (1) {
@@ -116,7 +154,19 @@
         gpio_pin_toggle_dt(&w_dog);
  #endif
         /* Run motor control tasks */
+ #if defined(CONFIG_APP_CYCLE_STATS)
+        const uint32_t start = k_cycle_get_32();
+ #endif
         super_elevator_task((void *)motor0);
+ #if defined(CONFIG_CANARD_TELEMETRY)
+        canard_telemetry_sample(motor0);
+ #endif
+ #if defined(CONFIG_CANARD_SCOPE)
+        canard_scope_sample(motor0);
+ #endif
+ #if defined(CONFIG_APP_CYCLE_STATS)
+        cycle_stats_add(&motor_loop_cycles, start);
+ #endif
         k_msleep(1);
      }
  }
@@ -146,8 +196,119 @@
 static fsm_cb_t elevator_handle = {
     .chState = 0,
 };
-uint8_t conctrl_cmd = 0;
-#define  RISING_DIS 3000.0f
+#define  RISING_DIS elevator_rising_dis
+#define  ZERO_OVERSHOOT 50.0f         //回零时多走一段, 保证压到零点开关
+#define  POSI_TOLERANCE 1.0f          //到位判定窗口
+#define  POSI_SETTLE_TICKS 50         //到位后保持的周期数
+#define  POSI_STALL_TICKS 1000        //未到位且高度无进展超过该周期数判为堵转
+
+/* canard 线程启动时(can_init 之前)恢复寄存器值, 此后只读 */
+float elevator_rising_dis = ELEVATOR_HEIGHT_MAX;
+
+BUILD_ASSERT(IS_POWER_OF_TWO(CONFIG_ELEVATOR_CMD_QUEUE_DEPTH),
+             "ELEVATOR_CMD_QUEUE_DEPTH must be a power of two");
+
+/* canard_thread 生产, super_elevator_task 消费 */
+SPSC_DEFINE(elevator_cmd_q, struct elevator_cmd, CONFIG_ELEVATOR_CMD_QUEUE_DEPTH);
+/* super_elevator_task 生产, canard_thread 消费 */
+SPSC_DEFINE(elevator_done_q, struct elevator_done, CONFIG_ELEVATOR_CMD_QUEUE_DEPTH);
+
+/* 当前正在执行的命令, type 为 ELEVATOR_CMD_NONE 表示空闲 */
+static struct elevator_cmd active_cmd;
+/* 以下两者取值均为 req_id + 1, 0 表示无 */
+static atomic_t running_req;  //电机线程写, canard_thread 据此开始超时计时
+static atomic_t cancel_req;   //canard_thread 写, 电机线程取走
+#if defined(CONFIG_ELEVATOR_GROUP)
+static int64_t group_stale_since;  //领队参考开始过期的时刻, 0 表示参考有效
+#endif
+
+/*
+ * 高度以零点为 0, 向上为正. 位置模式下 motor_set_target() 为相对行程,
+ * 负方向为顶升, 因此实际高度 = 零点处编码器位置 - 当前位置.
+ */
+static float zero_posi;
+static bool zero_valid;
+static float move_from;       //本次移动的起始高度
+static float move_to;         //本次移动的目标高度
+static float cur_height;      //最近一次测得的高度, 供 canard_thread 读取
+
+/* 上报状态每变化一次加一, canard_thread 据此立即发布 MovableAddons */
+static atomic_t elevator_state_seq;
+
+uint32_t super_elevator_state_seq(void)
+{
+    return (uint32_t)atomic_get(&elevator_state_seq);
+}
+
+int elevator_cmd_post(const struct elevator_cmd *cmd)
+{
+    struct elevator_cmd *slot = spsc_acquire(&elevator_cmd_q);
+
+    if (slot == NULL) {
+        return -ENOBUFS;
+    }
+    *slot = *cmd;
+    spsc_produce(&elevator_cmd_q);
+    return 0;
+}
+
+int elevator_done_get(struct elevator_done *done)
+{
+    struct elevator_done *rec = spsc_consume(&elevator_done_q);
+
+    if (rec == NULL) {
+        return -EAGAIN;
+    }
+    *done = *rec;
+    spsc_release(&elevator_done_q);
+    return 0;
+}
+
+bool elevator_cmd_running(uint8_t req_id)
+{
+    return atomic_get(&running_req) == (atomic_val_t)req_id + 1;
+}
+
+void elevator_cmd_cancel(uint8_t req_id)
+{
+    atomic_set(&cancel_req, (atomic_val_t)req_id + 1);
+}
+
+/* 空闲时从队列取下一条命令 */
+static void elevator_cmd_fetch(void)
+{
+    if (active_cmd.type != ELEVATOR_CMD_NONE) {
+        return;
+    }
+    struct elevator_cmd *cmd = spsc_consume(&elevator_cmd_q);
+    if (cmd == NULL) {
+        return;
+    }
+    active_cmd = *cmd;
+    spsc_release(&elevator_cmd_q);
+    atomic_set(&running_req, (atomic_val_t)active_cmd.req_id + 1);
+#if defined(CONFIG_ELEVATOR_GROUP)
+    group_stale_since = 0;
+#endif
+}
+
+/* 当前命令执行完毕, 状态切换之后调用, 以便上报最终状态 */
+static void elevator_cmd_complete(uint8_t result)
+{
+    struct elevator_done *rec = spsc_acquire(&elevator_done_q);
+
+    if (rec != NULL) {
+        rec->req_id = active_cmd.req_id;
+        rec->result = result;
+        rec->state = super_elevator_state();
+        rec->height = cur_height;
+        spsc_produce(&elevator_done_q);
+    } else {
+        LOG_RL_WRN("Completion queue full, req %u dropped", active_cmd.req_id);
+    }
+    active_cmd.type = ELEVATOR_CMD_NONE;
+    atomic_clear(&running_req);
+}
 enum{
     ELEVATOR_INIT = USER_STATUS,
     ELEVATOR_FINDZERO,
@@ -155,8 +316,264 @@ enum{
     ELEVATOR_ISZERO,
     ELEVATOR_ISEND,
     ELEVATOR_END,
+    ELEVATOR_POSITIONING,
+    ELEVATOR_HOLD,
+    ELEVATOR_RESTORE,
 };
-void super_elevator_task(void* obj)
+
+static float elevator_height(const struct device *motor)
+{
+    return zero_posi - motor_get_curposi(motor);
+}
+
+/* 静止状态下的名义高度 */
+static float elevator_rest_height(uint8_t state)
+{
+    if (state == ELEVATOR_END) {
+        return RISING_DIS;
+    } else if (state == ELEVATOR_HOLD) {
+        return move_to;
+    }
+    return 0.0f;
+}
+
+/* 下发一段相对行程, 电机就绪并启动后返回 true */
+static bool elevator_start_move(const struct device *motor, float posi)
+{
+    motor_set_target(motor, posi);
+    if (motor_get_state(motor) != MOTOR_STATE_READY) {
+        motor_set_state(motor, MOTOR_CMD_SET_ENABLE);
+        return false;
+    }
+    motor_set_state(motor, MOTOR_CMD_SET_START);
+    return true;
+}
+
+/* 当前指令的终点高度, 成组移动时随领队参考前移 */
+static float seg_end;
+/* 本次位置移动启动时的名义高度, 运行中改写目标时的相对行程以此为基准 */
+static float move_origin;
+static uint16_t posi_settle;  //POSITIONING 到位后已保持的周期数
+static uint16_t posi_stall;   //POSITIONING 高度无进展的周期数
+static float stall_ref;       //堵转判定的参考高度
+static uint16_t end_wait;     //ISEND 等待计数
+
+#if defined(CONFIG_ELEVATOR_GROUP)
+/*
+ * 成组时本节点当前可以指令到的高度: 朝 target 前进, 不越过领队的参考高度,
+ * 也不退回 commanded 之后. 参考过期时停在 commanded 等待, 持续超过
+ * ELEVATOR_GROUP_REF_TIMEOUT_MS 返回 false, 由调用者使命令失败.
+ */
+static bool elevator_group_end(bool up, float commanded, float target, float *end)
+{
+    float limit;
+
+    if (elevator_group_limit(up, commanded, &limit)) {
+        group_stale_since = 0;
+    } else {
+        const int64_t now = k_uptime_get();
+        if (group_stale_since == 0) {
+            group_stale_since = now;
+        } else if (now - group_stale_since > CONFIG_ELEVATOR_GROUP_REF_TIMEOUT_MS) {
+            group_stale_since = 0;
+            return false;
+        }
+    }
+    *end = up ? MIN(target, limit) : MAX(target, limit);
+    return true;
+}
+#endif
+
+/*
+ * 静止状态(ZERO/END/HOLD)下处理命令队列.
+ * 单机时全行程顶升/回零沿用 ISEND/ISZERO 的判定, 中间高度走 POSITIONING;
+ * 成组时所有移动都走 POSITIONING, 一次启动, 目标在运行中跟随领队参考.
+ */
+static void elevator_idle(fsm_cb_t *fsm, const struct device *motor)
+{
+    float target;
+
+    elevator_cmd_fetch();
+    switch (active_cmd.type) {
+    case ELEVATOR_CMD_OPEN:
+        target = RISING_DIS;
+        break;
+    case ELEVATOR_CMD_CLOSE:
+        target = 0.0f;
+        break;
+    case ELEVATOR_CMD_MOVE_TO:
+        target = CLAMP(active_cmd.height, 0.0f, RISING_DIS);
+        break;
+    default:
+        return;
+    }
+
+    const float from = elevator_rest_height(fsm->chState);
+    if (fabsf(target - from) <= POSI_TOLERANCE) {//已在目标位置
+        elevator_cmd_complete(ELEVATOR_RESULT_OK);
+        return;
+    }
+
+    float end = target;
+    bool group = false;
+#if defined(CONFIG_ELEVATOR_GROUP)
+    group = elevator_group_active();
+    if (group && !elevator_group_end(target > from, from, target, &end)) {
+        LOG_RL_ERR("No group reference, lift command %u failed", active_cmd.req_id);
+        elevator_cmd_complete(ELEVATOR_RESULT_FAIL);
+        return;
+    }
+#endif
+
+    float posi;
+    uint8_t next;
+    if (group) {//参考尚未到达时 end == from, 先以零行程启动, 原地等待
+        posi = -(end - from);
+        next = ELEVATOR_POSITIONING;
+    } else if (target <= POSI_TOLERANCE) {
+        posi = from + ZERO_OVERSHOOT;
+        next = ELEVATOR_ISZERO;
+    } else if (target >= RISING_DIS - POSI_TOLERANCE) {
+        posi = -(RISING_DIS - from);
+        next = ELEVATOR_ISEND;
+    } else {
+        posi = -(target - from);
+        next = ELEVATOR_POSITIONING;
+    }
+
+#if defined(CONFIG_ELEVATOR_HOMING_PERSIST)
+    //参考先作废(含 flash)再启动, 移动中掉电一律重新回零
+    if (!elevator_persist_invalidate()) {
+        return;
+    }
+#endif
+    if (!elevator_start_move(motor, posi)) {
+        return;
+    }
+    move_from = from;
+    move_to = target;
+    move_origin = from;
+    seg_end = end;
+    stall_ref = from;
+    posi_stall = 0;
+    fsm->chState = next;
+}
+
+/*
+ * 成组移动中让目标跟随领队参考前移: 只改写位置环目标, 不重新启动电机,
+ * 组内节点因此全速同步运行. 组解散后直接放行到最终目标.
+ * 参考长时间过期返回 false.
+ */
+static bool elevator_follow(const struct device *motor)
+{
+    if (seg_end == move_to) {
+        return true;
+    }
+    float end = move_to;
+#if defined(CONFIG_ELEVATOR_GROUP)
+    if (elevator_group_active() &&
+        !elevator_group_end(move_to > move_from, seg_end, move_to, &end)) {
+        return false;
+    }
+#endif
+    if (end != seg_end) {
+        motor_set_target(motor, -(end - move_origin));
+        seg_end = end;
+    }
+    return true;
+}
+
+/* POSITIONING 到达最终目标: 回零时压过零点开关重新建立基准, 否则结束本次移动 */
+static void elevator_move_done(fsm_cb_t *fsm, const struct device *motor)
+{
+    if (move_to <= POSI_TOLERANCE) {
+        if (elevator_start_move(motor, ZERO_OVERSHOOT)) {
+            fsm->chState = ELEVATOR_ISZERO;
+        }
+        return;
+    }
+    fsm->chState = (move_to >= RISING_DIS - POSI_TOLERANCE) ? ELEVATOR_END : ELEVATOR_HOLD;
+    elevator_cmd_complete(ELEVATOR_RESULT_OK);
+}
+
+/* 停止移动并以 HOLD 状态停在实测高度, 结束当前命令 */
+static void elevator_stop(fsm_cb_t *fsm, const struct device *motor, uint8_t result)
+{
+    const uint8_t st = fsm->chState;
+
+    if (st == ELEVATOR_POSITIONING || st == ELEVATOR_ISEND || st == ELEVATOR_ISZERO) {
+        motor_set_state(motor, MOTOR_CMD_SET_DISABLE);
+        cur_height = elevator_height(motor);
+        move_from = cur_height;
+        move_to = cur_height;
+        posi_settle = 0;
+        posi_stall = 0;
+        end_wait = 0;
+        fsm->chState = ELEVATOR_HOLD;
+    }
+    elevator_cmd_complete(result);
+}
+
+/*
+ * 处理 canard_thread 的取消请求: 只取消正在执行的命令. 移动中则停在
+ * 当前高度, 以 HOLD 状态等待下一条命令; 零点未建立时不会有命令在执行.
+ */
+static void elevator_cancel_poll(fsm_cb_t *fsm, const struct device *motor)
+{
+    const atomic_val_t req = atomic_clear(&cancel_req);
+
+    if (req == 0 || active_cmd.type == ELEVATOR_CMD_NONE ||
+        req != (atomic_val_t)active_cmd.req_id + 1) {
+        return;
+    }
+    LOG_WRN("Lift command %u aborted at height %d", active_cmd.req_id,
+            (int)elevator_height(motor));
+    elevator_stop(fsm, motor, ELEVATOR_RESULT_ABORTED);
+}
+
+/* POSITIONING 未到位时的堵转判定: 高度持续 POSI_STALL_TICKS 无进展 */
+static bool elevator_stalled(float height)
+{
+    if (fabsf(height - stall_ref) > POSI_TOLERANCE) {
+        stall_ref = height;
+        posi_stall = 0;
+        return false;
+    }
+    return ++posi_stall >= POSI_STALL_TICKS;
+}
+
+/*
+ * 自整定只在 HOLD 开始. 继电器会让顶升偏离 move_to, 接管前先作废保存的
+ * 参考(含 flash), 结束后以实测高度作为新的 HOLD 高度并重新保存.
+ * 实验占用电机期间返回 true.
+ */
+static bool elevator_autotune(fsm_cb_t *fsm, const struct device *motor)
+{
+    static bool owned;
+    const bool hold = (fsm->chState == ELEVATOR_HOLD);
+
+#if defined(CONFIG_ELEVATOR_HOMING_PERSIST)
+    if (hold && pid_autotune_requested() && !elevator_persist_invalidate()) {
+        return false;   //作废参考的 flash 写入尚未完成, 稍后再接管
+    }
+#endif
+    if (pid_autotune_step(motor, hold)) {
+        owned = true;
+        return true;
+    }
+    if (owned) {
+        owned = false;
+        cur_height = elevator_height(motor);
+        move_from = cur_height;
+        move_to = cur_height;
+#if defined(CONFIG_ELEVATOR_HOMING_PERSIST)
+        elevator_persist_save(cur_height);
+#endif
+    }
+    return false;
+}
+
+APP_HOT_TEXT void super_elevator_task(void* obj)
 {
 
     fsm_cb_t* elevator_fsm = &elevator_handle;
@@ -167,18 +584,49 @@ void super_elevator_task(void* obj)
     const struct motor_config *cfg = motor->config;
     data = motor->data;
 
+#if defined(CONFIG_APP_PID_APPLY)
+    /* Swap in PID parameters staged by canard_thread */
+    const float *pid;
+    if (canard_if_pid_due(&pid) && motor_pid_apply(motor, pid) < 0) {
+        LOG_WRN("PID parameters not applied");
+    }
+#endif
+
     /* Run state machine */
     DISPATCH_FSM(cfg->fsm);
+    //只在中间高度静止时开始, 保证继电器上下都有行程余量; 实验期间暂停顶升状态机
+    if (elevator_autotune(elevator_fsm, motor)) {
+        return;
+    }
     int switch_state;
     elevator_fsm->p1 = (void *)motor;
+    elevator_cancel_poll(elevator_fsm, motor);
     switch (elevator_fsm->chState) {
         case ENTER:
         case ELEVATOR_INIT:
             {
                 switch_state = gpio_pin_get_dt(&prx_switch);
                 if (switch_state < 0) {
-                    LOG_WRN("Failed to read proximity switch");
+                    LOG_RL_WRN("Failed to read proximity switch");
                 } else {//电机正转 找零点
+#if defined(CONFIG_ELEVATOR_HOMING_PERSIST)
+                    //复位前已回零且静止在零点以上, 直接恢复, 不再走找零行程
+                    static bool restore_checked;
+                    float height;
+                    if(!restore_checked && switch_state == 0)
+                    {
+                        restore_checked = true;
+                        if(elevator_persist_restore(&height) == 0 && height > POSI_TOLERANCE)
+                        {
+                            move_from = height;
+                            move_to = height;
+                            motor_set_target(motor,0.0f);
+                            motor_set_mode(motor, MOTOR_MODE_POSI);
+                            elevator_fsm->chState = ELEVATOR_RESTORE;
+                            break;
+                        }
+                    }
+#endif
                     if(switch_state == 0)
                     {
                         if(motor_get_mode(motor) != MOTOR_MODE_SPEED )
@@ -196,7 +644,7 @@ void super_elevator_task(void* obj)
                     }else{
                         elevator_fsm->chState = ELEVATOR_FINDZERO;
                     }
-                    LOG_DBG("Proximity switch state: %d", switch_state);
+                    LOG_RL_DBG("Proximity switch state: %d", switch_state);
                 }
             }
             break;
@@ -208,6 +656,7 @@ void super_elevator_task(void* obj)
                 {
                     motor_set_target(motor,0.0f);
                     motor_set_mode(motor, MOTOR_MODE_POSI);
+                    zero_valid = false;
                     elevator_fsm->chState = ELEVATOR_ZERO;
                 }
             }
@@ -218,63 +667,91 @@ void super_elevator_task(void* obj)
                 {
                     break;
                 }
-
-                //添加对顶升命令的响应
-                if(conctrl_cmd != 1)
+                if(!zero_valid)//切换到位置模式后记录零点
                 {
-                    break;
+                    zero_posi = motor_get_curposi(motor);
+                    zero_valid = true;
                 }
 
-                if(motor_get_state(motor) != MOTOR_STATE_READY)
-                {
-                    float posi = -RISING_DIS;
-                    motor_set_target(motor,posi); 
-                    motor_set_state(motor,MOTOR_CMD_SET_ENABLE);
-                    break;
-                }
-                motor_set_state(motor,MOTOR_CMD_SET_START);
-                conctrl_cmd = 0;
-                elevator_fsm->chState = ELEVATOR_ISEND;
+                //添加对顶升命令的响应
+                elevator_idle(elevator_fsm, motor);
             }
             break;
 
         case ELEVATOR_ISEND ://等待5s使其达到远端
             {
                 {
-                    static uint16_t conut = 0;
-                    conut++;
-                    if(fabsf(motor_get_curposi(motor)) < RISING_DIS - 0.001f)//已经到达位置
+                    end_wait++;
+                    if(elevator_height(motor) < RISING_DIS - 0.001f)//已经到达位置
                     {
                         break;
                     }
 
-                    if(conut>3100)
+                    if(end_wait>3100)
                     {
-                        conut = 0;
-                        elevator_fsm->chState = ELEVATOR_END;    
+                        end_wait = 0;
+                        elevator_fsm->chState = ELEVATOR_END;
+                        elevator_cmd_complete(ELEVATOR_RESULT_OK);
                     }
                     // motor_set_state(motor,MOTOR_CMD_SET_DISABLE);
                 }
             }
             break;
 
-        case ELEVATOR_END:
+        case ELEVATOR_END://远端, 等待回零点或定位指令
+        case ELEVATOR_HOLD://中间高度
+            elevator_idle(elevator_fsm, motor);
+            break;
+
+        case ELEVATOR_POSITIONING://移动到中间高度
             {
-                //1、等待回零点指令
-                if(conctrl_cmd != 2)
+                if(!elevator_follow(motor))
+                {
+                    LOG_RL_ERR("No group reference, lift stopped at height %d", (int)cur_height);
+                    elevator_stop(elevator_fsm, motor, ELEVATOR_RESULT_FAIL);
+                    break;
+                }
+                const float height = elevator_height(motor);
+                if(fabsf(height - seg_end) > POSI_TOLERANCE)
                 {
+                    posi_settle = 0;
+                    if(elevator_stalled(height))
+                    {
+                        LOG_RL_ERR("Lift stalled at height %d, target %d", (int)height, (int)seg_end);
+                        elevator_stop(elevator_fsm, motor, ELEVATOR_RESULT_FAIL);
+                    }
                     break;
                 }
-                if(motor_get_state(motor) != MOTOR_STATE_READY)
+                posi_stall = 0;
+                //跟到领队参考处等待组内其他节点, 到达最终目标后稳定一段时间
+                if(fabsf(seg_end - move_to) > POSI_TOLERANCE)
+                {
+                    posi_settle = 0;
+                    break;
+                }
+                if(posi_settle < POSI_SETTLE_TICKS)
+                {
+                    posi_settle++;
+                    break;
+                }
+                elevator_move_done(elevator_fsm, motor);
+                if(elevator_fsm->chState != ELEVATOR_POSITIONING)
+                {
+                    posi_settle = 0;
+                }
+            }
+            break;
+
+        case ELEVATOR_RESTORE://等待位置模式生效后以保存的高度重建零点
+            {
+                if(motor_get_mode(motor) != MOTOR_MODE_POSI)
                 {
-                    float posi = RISING_DIS + 50;
-                    motor_set_target(motor,posi);                
-                    motor_set_state(motor,MOTOR_CMD_SET_ENABLE);
                     break;
                 }
-                motor_set_state(motor,MOTOR_CMD_SET_START);
-                conctrl_cmd = 0;
-                elevator_fsm->chState = ELEVATOR_ISZERO;
+                zero_posi = motor_get_curposi(motor) + move_to;
+                zero_valid = true;
+                elevator_fsm->chState = (move_to >= RISING_DIS - POSI_TOLERANCE) ?
+                                        ELEVATOR_END : ELEVATOR_HOLD;
             }
             break;
 
@@ -285,11 +762,43 @@ void super_elevator_task(void* obj)
                 break;
 
             }
+            zero_posi = motor_get_curposi(motor);//重新以零点开关为基准
+            zero_valid = true;
             elevator_fsm->chState = ELEVATOR_ZERO;
+            elevator_cmd_complete(ELEVATOR_RESULT_OK);
             break;
         case EXIT:
             break;
     }
+
+    if (zero_valid) {
+        cur_height = elevator_height(motor);
+    }
+#if defined(CONFIG_ELEVATOR_GROUP)
+    elevator_group_set_self(super_elevator_state(), cur_height,
+                            elevator_fsm->chState == ELEVATOR_POSITIONING ||
+                            active_cmd.type != ELEVATOR_CMD_NONE,
+                            move_to > move_from);
+#endif
+
+    static int8_t last_state;
+    int8_t state = super_elevator_state();
+    if (state != last_state) {
+        last_state = state;
+        atomic_inc(&elevator_state_seq);
+#if defined(CONFIG_ELEVATOR_HOMING_PERSIST)
+        //只在静止状态保存参考, 其余状态(找零/移动中)一律作废
+        const uint8_t st = elevator_fsm->chState;
+        if (st == ELEVATOR_ZERO || st == ELEVATOR_END || st == ELEVATOR_HOLD) {
+            elevator_persist_save(elevator_rest_height(st));
+        } else {
+            (void)elevator_persist_invalidate();
+        }
+#endif
+    }
+#if defined(CONFIG_CANARD_BLACKBOX)
+    canard_blackbox_track(motor, elevator_fsm->chState);
+#endif
 }
 /**
 uint8 INIT = 0
@@ -317,8 +826,47 @@ int8_t super_elevator_state(void)
         state = 4;
     }else if(elevator_handle.chState == ELEVATOR_ISZERO){
         state = 5;
+    }else if(elevator_handle.chState == ELEVATOR_POSITIONING){
+        state = (move_to > move_from) ? 3 : 5;
+    }else if(elevator_handle.chState == ELEVATOR_HOLD){
+        state = 6;
+    }else if(elevator_handle.chState == ELEVATOR_RESTORE){
+        state = 1;
     }else{//急停状态，后续补充
 
     }
     return state;
-}
\ No newline at end of file
+}
+
+float super_elevator_height(void)
+{
+    return cur_height;
+}
+
+#if defined(CONFIG_CANARD_SCOPE)
+/* 示波器应用变量, 编号与 canard_scope.h 中的 CANARD_SCOPE_VAR_APP 对应 */
+static float scope_elevator_fsm(const struct device *motor)
+{
+    ARG_UNUSED(motor);
+    return (float)elevator_handle.chState;
+}
+
+static float scope_elevator_height(const struct device *motor)
+{
+    ARG_UNUSED(motor);
+    return cur_height;
+}
+
+static float scope_elevator_target(const struct device *motor)
+{
+    ARG_UNUSED(motor);
+    return move_to;
+}
+
+static void elevator_scope_register(void)
+{
+    canard_scope_register(CANARD_SCOPE_VAR_APP + 0, scope_elevator_fsm);
+    canard_scope_register(CANARD_SCOPE_VAR_APP + 1, scope_elevator_height);
+    canard_scope_register(CANARD_SCOPE_VAR_APP + 2, scope_elevator_target);
+}
+#endif
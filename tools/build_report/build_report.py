@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+"""Size, placement and cycle comparison of a debug and a release build.
+
+Compares two Zephyr build directories of the same app, typically the
+default (debug) configuration and one built with release.conf:
+
+  * output section sizes of zephyr.elf, with the difference
+  * the output section every hot-path symbol ended up in, which shows
+    whether CONFIG_APP_TCM_PLACEMENT moved it to ITCM/DTCM
+  * cycle counts measured on target, when console logs of both builds
+    with CONFIG_APP_CYCLE_STATS=y are given
+
+Nothing is estimated: sizes and addresses come from the ELF files, cycle
+counts from the "cycles <path>: avg A max M n N" log lines. Per path the
+averages of all report windows are averaged and the largest maximum is
+taken; windows with n = 0 are skipped.
+
+Usage:
+  west build -b <board> -d build/debug apps/superlift -- -DCONFIG_APP_CYCLE_STATS=y
+  west build -b <board> -d build/release apps/superlift -- \\
+      -DEXTRA_CONF_FILE=release.conf -DCONFIG_APP_CYCLE_STATS=y
+  build_report.py build/debug build/release \\
+      --debug-log debug_rtt.log --release-log release_rtt.log
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+HOT_SYMBOLS = [
+    "can_rx_callback",
+    "canard_process_rx",
+    "canardRxAccept",
+    "wheelmotor_task",
+    "super_elevator_task",
+    "canard_mem_pool",
+    "rx_msgq_hi_buf",
+    "rx_msgq_buf",
+]
+
+CYCLES_RE = re.compile(r"cycles (\S+): avg (\d+) max (\d+) n (\d+)")
+
+
+def elf_path(build_dir):
+    path = os.path.join(build_dir, "zephyr", "zephyr.elf")
+    if not os.path.isfile(path):
+        sys.exit("%s: no zephyr/zephyr.elf" % build_dir)
+    return path
+
+
+def run(tool, *args):
+    return subprocess.run([tool] + list(args), check=True,
+                          capture_output=True, text=True).stdout
+
+
+def sections(prefix, elf):
+    """Allocated output sections as {name: (size, addr)}, from size -A."""
+    out = {}
+    for line in run(prefix + "size", "-A", "-d", elf).splitlines():
+        f = line.split()
+        if len(f) != 3 or not f[1].isdigit() or not f[2].isdigit():
+            continue
+        size, addr = int(f[1]), int(f[2])
+        if addr != 0 or f[0] in ("itcm", ".itcm"):
+            out[f[0]] = (size, addr)
+    return out
+
+
+def symbols(prefix, elf):
+    """{name: addr}; LTO suffixes such as .lto_priv.0 are stripped."""
+    out = {}
+    for line in run(prefix + "nm", elf).splitlines():
+        f = line.split()
+        if len(f) != 3:
+            continue
+        name = f[2].split(".")[0]
+        out.setdefault(name, int(f[0], 16))
+    return out
+
+
+def section_of(addr, secs):
+    for name, (size, base) in secs.items():
+        if size > 0 and base <= addr < base + size:
+            return name
+    return "?"
+
+
+def cycles(log):
+    """{path: (mean avg, max, windows)} from a console log."""
+    acc = {}
+    with open(log, errors="replace") as f:
+        for line in f:
+            m = CYCLES_RE.search(line)
+            if not m or int(m.group(4)) == 0:
+                continue
+            a = acc.setdefault(m.group(1), [0, 0, 0])
+            a[0] += int(m.group(2))
+            a[1] = max(a[1], int(m.group(3)))
+            a[2] += 1
+    return {k: (v[0] / v[2], v[1], v[2]) for k, v in acc.items()}
+
+
+def delta(a, b):
+    if a is None or b is None:
+        return "-"
+    if a == 0:
+        return "%+d" % (b - a)
+    return "%+d (%+.1f%%)" % (b - a, 100.0 * (b - a) / a)
+
+
+def fmt(v):
+    return "-" if v is None else "%d" % v
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("debug", help="build directory of the debug build")
+    ap.add_argument("release", help="build directory of the release build")
+    ap.add_argument("--debug-log", help="console log of the debug build")
+    ap.add_argument("--release-log", help="console log of the release build")
+    ap.add_argument("--prefix", default="arm-zephyr-eabi-",
+                    help="binutils prefix (default: %(default)s)")
+    args = ap.parse_args()
+
+    elves = [elf_path(args.debug), elf_path(args.release)]
+    secs = [sections(args.prefix, e) for e in elves]
+    syms = [symbols(args.prefix, e) for e in elves]
+
+    print("## Sections (bytes)\n")
+    print("| section | debug | release | delta |")
+    print("|---|---:|---:|---:|")
+    names = sorted(set(secs[0]) | set(secs[1]),
+                   key=lambda n: min(s[n][1] for s in secs if n in s))
+    for n in names:
+        a = secs[0].get(n, (None,))[0]
+        b = secs[1].get(n, (None,))[0]
+        print("| %s | %s | %s | %s |" % (n, fmt(a), fmt(b), delta(a, b)))
+
+    print("\n## Hot path placement\n")
+    print("| symbol | debug | release |")
+    print("|---|---|---|")
+    for s in HOT_SYMBOLS:
+        cols = []
+        for i in range(2):
+            addr = syms[i].get(s)
+            cols.append("-" if addr is None else
+                        "%s @0x%08x" % (section_of(addr, secs[i]), addr))
+        if cols != ["-", "-"]:
+            print("| %s | %s | %s |" % (s, cols[0], cols[1]))
+
+    if args.debug_log and args.release_log:
+        cyc = [cycles(args.debug_log), cycles(args.release_log)]
+        print("\n## Cycles (mean of window averages / largest maximum)\n")
+        print("| path | debug avg | release avg | delta | debug max | release max | delta |")
+        print("|---|---:|---:|---:|---:|---:|---:|")
+        for p in sorted(set(cyc[0]) | set(cyc[1])):
+            a = cyc[0].get(p, (None, None, 0))
+            b = cyc[1].get(p, (None, None, 0))
+            print("| %s | %s | %s | %s | %s | %s | %s |" % (
+                p, fmt(a[0]), fmt(b[0]), delta(a[0], b[0]),
+                fmt(a[1]), fmt(b[1]), delta(a[1], b[1])))
+    elif args.debug_log or args.release_log:
+        ap.error("cycle comparison needs both --debug-log and --release-log")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
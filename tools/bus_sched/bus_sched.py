@@ -0,0 +1,260 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: Apache-2.0
+"""Offline schedulability analysis of a Cyphal/CAN node's traffic.
+
+Reads a node traffic table (apps/<app>/bus_table.json) and computes, for a
+fleet of N identical nodes sharing one bus:
+
+  * frames per transfer and worst-case transmission time
+  * bus utilization, overall and per Cyphal priority
+  * worst-case response time of every transfer (queuing + transmission)
+
+Response times follow the revised CAN analysis of Davis, Burns, Bril and
+Lukkien, "Controller Area Network (CAN) schedulability analysis: Refuted,
+revisited and revised", Real-Time Systems 35(3), 2007. A multi-frame
+transfer is treated as one job whose length is the sum of its frames;
+blocking is one maximum-length lower-priority frame. Controllers are
+assumed to have no priority inversion in their TX buffers.
+
+Table format:
+
+  {
+    "node": "superlift",
+    "bitrate": 1000000,          # arbitration bit rate
+    "data_bitrate": 0,           # CAN FD data phase, 0 = classic CAN
+    "transfers": [               # replicated for every node of the fleet
+      {"name": "heartbeat", "kind": "message", "port": 7509,
+       "priority": "nominal", "payload": 7, "period_ms": 1000}
+    ],
+    "shared": [                  # sent once per bus (e.g. time master)
+      ...
+    ]
+  }
+
+kind is one of message, request (host -> node) or response (node -> host).
+period_ms is the period or minimum inter-arrival time. deadline_ms
+defaults to period_ms, jitter_ms to 0. port null means unknown, which is
+analysed as the lowest-priority identifier of its Cyphal priority.
+"estimate": true marks a payload size that is not an exact bound.
+
+Usage:
+  bus_sched.py apps/superlift/bus_table.json --nodes 8
+  bus_sched.py apps/super/bus_table.json --nodes 4 --data-bitrate 4000000
+"""
+
+import argparse
+import json
+import math
+import sys
+
+PRIORITIES = ["exceptional", "immediate", "fast", "high",
+              "nominal", "low", "slow", "optional"]
+
+FD_DLC_SIZES = [0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64]
+
+HOST_NODE_ID = 127
+
+
+def classic_frame_bits(size):
+    """Worst-case bits of an extended classic frame, stuffing included."""
+    return 54 + 8 * size + 13 + (54 + 8 * size - 1) // 4
+
+
+def fd_frame_time_us(size, bitrate, data_bitrate):
+    """Worst-case duration of an extended CAN FD frame with bit rate switch.
+
+    Arbitration (SOF .. BRS) and the ACK/EOF/IFS tail run at the nominal
+    rate, ESI .. CRC delimiter at the data rate. Dynamic stuffing is
+    bounded by one bit per four, the CRC field carries fixed stuff bits.
+    """
+    arb = 33
+    arb += (arb - 1) // 4
+    crc = 17 if size <= 16 else 21
+    data = 1 + 4 + 8 * size                 # ESI, DLC, data
+    data += (data - 1) // 4
+    data += 4 + crc + (4 + crc + 3) // 4    # stuff count + CRC, fixed stuffing
+    data += 1                               # CRC delimiter
+    tail = 2 + 7 + 3                        # ACK, EOF, IFS
+    return (arb + tail) * 1e6 / bitrate + data * 1e6 / data_bitrate
+
+
+def fd_round_up(size):
+    for s in FD_DLC_SIZES:
+        if s >= size:
+            return s
+    raise ValueError("frame larger than 64 bytes")
+
+
+def transfer_frames(payload, mtu):
+    """Frame payload sizes of a Cyphal transfer (tail byte, CRC, padding)."""
+    if payload + 1 <= mtu:
+        sizes = [payload + 1]
+    else:
+        total = payload + 2                 # transfer CRC
+        per = mtu - 1
+        n = math.ceil(total / per)
+        sizes = [mtu] * (n - 1) + [total - per * (n - 1) + 1]
+    if mtu > 8:
+        sizes = [fd_round_up(s) for s in sizes]
+    return sizes
+
+
+def can_id(entry, node_id):
+    """29-bit Cyphal CAN identifier; a lower value wins arbitration."""
+    prio = PRIORITIES.index(entry["priority"])
+    port = entry.get("port")
+    kind = entry["kind"]
+    if kind == "message":
+        subject = 8191 if port is None else port
+        return (prio << 26) | (3 << 21) | (subject << 8) | node_id
+    service = 511 if port is None else port
+    request = 1 if kind == "request" else 0
+    src, dst = (HOST_NODE_ID, node_id) if request else (node_id, HOST_NODE_ID)
+    return (prio << 26) | (1 << 25) | (request << 24) | (service << 14) | (dst << 7) | src
+
+
+class Job:
+    def __init__(self, entry, node_id, bitrate, data_bitrate):
+        self.name = entry["name"]
+        self.node_id = node_id
+        self.priority = entry["priority"]
+        self.estimate = entry.get("estimate", False)
+        self.id = can_id(entry, node_id)
+        self.period = entry["period_ms"] * 1000.0
+        self.deadline = entry.get("deadline_ms", entry["period_ms"]) * 1000.0
+        self.jitter = entry.get("jitter_ms", 0) * 1000.0
+        mtu = 64 if data_bitrate else 8
+        self.frames = transfer_frames(entry["payload"], mtu)
+        if data_bitrate:
+            times = [fd_frame_time_us(s, bitrate, data_bitrate) for s in self.frames]
+        else:
+            times = [classic_frame_bits(s) * 1e6 / bitrate for s in self.frames]
+        self.cost = sum(times)
+        self.max_frame = max(times)
+        self.response = None
+
+
+def build_jobs(table, nodes, base_id, bitrate, data_bitrate):
+    jobs = []
+    for n in range(nodes):
+        for e in table.get("transfers", []):
+            jobs.append(Job(e, base_id + n, bitrate, data_bitrate))
+    for e in table.get("shared", []):
+        jobs.append(Job(e, e.get("node_id", 1), bitrate, data_bitrate))
+    return jobs
+
+
+def analyse(jobs, bitrate):
+    tau_bit = 1e6 / bitrate
+    jobs.sort(key=lambda j: j.id)
+    utilization = sum(j.cost / j.period for j in jobs)
+    if utilization >= 1.0:
+        return utilization
+
+    for i, m in enumerate(jobs):
+        hp = jobs[:i]
+        lower = [j.max_frame for j in jobs[i + 1:]]
+        blocking = max(lower) if lower else 0.0
+
+        # level-m busy period
+        t = m.cost
+        while True:
+            nt = blocking + sum(math.ceil((t + k.jitter) / k.period) * k.cost
+                                for k in hp + [m])
+            if nt <= t:
+                break
+            t = nt
+        instances = math.ceil((t + m.jitter) / m.period)
+
+        worst = 0.0
+        w = blocking
+        for q in range(instances):
+            w = max(w, blocking + q * m.cost)
+            while True:
+                nw = blocking + q * m.cost + sum(
+                    math.ceil((w + k.jitter + tau_bit) / k.period) * k.cost for k in hp)
+                if nw <= w:
+                    break
+                w = nw
+            worst = max(worst, m.jitter + w - q * m.period + m.cost)
+        m.response = worst
+    return utilization
+
+
+def report(table, jobs, utilization, args):
+    mode = ("CAN FD %d/%d bit/s" % (args.bitrate, args.data_bitrate)
+            if args.data_bitrate else "classic CAN %d bit/s" % args.bitrate)
+    print("%s: %d node(s), %s" % (table.get("node", "?"), args.nodes, mode))
+    print("bus utilization %.1f %%" % (utilization * 100.0))
+    if utilization >= 1.0:
+        print("OVERLOADED: utilization >= 100 %, response times unbounded")
+        return 1
+
+    print()
+    print("%-28s %4s %-11s %9s %6s %9s %9s %9s  %s" % (
+        "transfer", "node", "priority", "can_id", "frames", "C_us", "T_ms", "R_us", ""))
+    failed = 0
+    for j in jobs:
+        ok = j.response <= j.deadline
+        failed += 0 if ok else 1
+        flag = ("" if ok else "MISS") + (" ~payload" if j.estimate else "")
+        print("%-28s %4d %-11s %9x %6d %9.1f %9.1f %9.1f  %s" % (
+            j.name, j.node_id, j.priority, j.id, len(j.frames), j.cost,
+            j.period / 1000.0, j.response, flag))
+
+    print()
+    print("%-11s %8s %10s" % ("priority", "util_%", "worst_R_us"))
+    for p in PRIORITIES:
+        sel = [j for j in jobs if j.priority == p]
+        if not sel:
+            continue
+        print("%-11s %8.2f %10.1f" % (
+            p, 100.0 * sum(j.cost / j.period for j in sel), max(j.response for j in sel)))
+
+    if failed:
+        print("\n%d transfer(s) miss their deadline" % failed)
+    return 1 if failed else 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("table", help="node traffic table (JSON)")
+    ap.add_argument("--nodes", type=int, default=1, help="identical nodes on the bus")
+    ap.add_argument("--node-id-base", type=int, default=10,
+                    help="node ID of the first node, the others follow")
+    ap.add_argument("--bitrate", type=int, help="arbitration bit rate, overrides the table")
+    ap.add_argument("--data-bitrate", type=int,
+                    help="CAN FD data bit rate, 0 for classic CAN, overrides the table")
+    ap.add_argument("--json", action="store_true", help="machine-readable output")
+    args = ap.parse_args()
+
+    with open(args.table) as f:
+        table = json.load(f)
+    if args.bitrate is None:
+        args.bitrate = table.get("bitrate", 1000000)
+    if args.data_bitrate is None:
+        args.data_bitrate = table.get("data_bitrate", 0)
+    if args.node_id_base + args.nodes - 1 >= HOST_NODE_ID:
+        ap.error("node IDs must stay below %d" % HOST_NODE_ID)
+
+    jobs = build_jobs(table, args.nodes, args.node_id_base, args.bitrate, args.data_bitrate)
+    utilization = analyse(jobs, args.bitrate)
+
+    if args.json:
+        json.dump({
+            "utilization": utilization,
+            "transfers": [{
+                "name": j.name, "node_id": j.node_id, "priority": j.priority,
+                "can_id": j.id, "frames": len(j.frames), "cost_us": j.cost,
+                "period_us": j.period, "deadline_us": j.deadline,
+                "response_us": j.response,
+            } for j in jobs],
+        }, sys.stdout, indent=2)
+        print()
+        return 0 if utilization < 1.0 and all(
+            j.response <= j.deadline for j in jobs) else 1
+    return report(table, jobs, utilization, args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())